@@ -0,0 +1,93 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "VividText.h"
+#include "VividTextBatch.h"
+
+// Draws 10k small labels one by one and through a VividTextBatch, moving a few of them every frame.
+// Usage: BatchBenchmark [font file] [label count] [frames]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	void moveSome(std::vector<std::unique_ptr<sfv::VividText>>& labels, std::size_t frame)
+	{
+		// One label in a hundred moves, a few change their number like damage numbers do
+		for (std::size_t index = frame % 100; index < labels.size(); index += 100) {
+			labels[index]->move(0.f, -1.f);
+		}
+		for (std::size_t index = frame % 1000; index < labels.size(); index += 1000) {
+			labels[index]->setString(std::to_string(frame * 7 % 1000));
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+	const std::size_t frames = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+	sf::RenderTexture target;
+	target.create(1920, 1080);
+
+	std::vector<std::unique_ptr<sfv::VividText>> labels;
+	for (std::size_t index = 0; index != count; ++index) {
+		labels.emplace_back(new sfv::VividText("Goblin " + std::to_string(index), font));
+		sfv::VividText& label = *labels.back();
+		label.setCharacterSize(14);
+		label.setFillColor(sf::Color::Red, 0, 6);
+		label.setOutlineThickness(1.f);
+		label.setPosition(static_cast<float>(index % 100) * 19.f, static_cast<float>(index / 100) * 10.f);
+	}
+
+	// Warm both paths up so glyph loading is not measured
+	for (const auto& label : labels) {
+		target.draw(*label);
+	}
+	sfv::VividTextBatch batch;
+	for (const auto& label : labels) {
+		batch.add(*label);
+	}
+	target.draw(batch);
+	target.display();
+
+	Clock::time_point start = Clock::now();
+	for (std::size_t frame = 0; frame != frames; ++frame) {
+		moveSome(labels, frame);
+		target.clear();
+		for (const auto& label : labels) {
+			target.draw(*label);
+		}
+		target.display();
+	}
+	const double individual = milliseconds(Clock::now() - start) / static_cast<double>(frames);
+
+	start = Clock::now();
+	for (std::size_t frame = 0; frame != frames; ++frame) {
+		moveSome(labels, frame);
+		target.clear();
+		target.draw(batch);
+		target.display();
+	}
+	const double batched = milliseconds(Clock::now() - start) / static_cast<double>(frames);
+
+	std::cout << "labels: " << count << ", frames: " << frames << std::endl;
+	std::cout << "individual: " << individual << " ms/frame" << std::endl;
+	std::cout << "batched: " << batched << " ms/frame, " << batch.getBatchCount() << " draw calls" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "VividText.h"
+
+// Animates a rainbow across a text, giving every character a new color each frame,
+// once with a run per character and once with the per character fill colors.
+// Usage: GradientBenchmark [font file] [characters] [frames]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	sf::Color rainbow(std::size_t character, std::size_t frame)
+	{
+		const float phase = static_cast<float>(character) * 0.1f + static_cast<float>(frame) * 0.05f;
+		const auto channel = [phase](float shift) {
+			return static_cast<sf::Uint8>(127.5f + 127.5f * std::sin(phase + shift));
+		};
+		return sf::Color(channel(0.f), channel(2.094f), channel(4.189f));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t characters = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+	const std::size_t frames = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::string string;
+	for (std::size_t character = 0; character != characters; ++character) {
+		string += character % 80 == 79 ? '\n' : static_cast<char>('a' + character % 26);
+	}
+
+	sfv::VividText runs(string, font);
+	runs.getLocalBounds();
+	double perRun = 0.0;
+	for (std::size_t frame = 0; frame != frames; ++frame) {
+		const Clock::time_point start = Clock::now();
+		for (std::size_t character = 0; character != characters; ++character) {
+			runs.setFillColor(rainbow(character, frame), character, 1);
+		}
+		runs.getLocalBounds();
+		perRun += milliseconds(Clock::now() - start);
+	}
+
+	sfv::VividText glyphs(string, font);
+	glyphs.getLocalBounds();
+	std::vector<sf::Color> colors(characters);
+	double perGlyph = 0.0;
+	for (std::size_t frame = 0; frame != frames; ++frame) {
+		const Clock::time_point start = Clock::now();
+		for (std::size_t character = 0; character != characters; ++character) {
+			colors[character] = rainbow(character, frame);
+		}
+		glyphs.setGlyphFillColors(colors.data(), 0, colors.size());
+		glyphs.getLocalBounds();
+		perGlyph += milliseconds(Clock::now() - start);
+	}
+
+	const double count = static_cast<double>(frames);
+	std::cout << "characters: " << characters << ", frames: " << frames << std::endl;
+	std::cout << "run per character: " << perRun / count << " ms/frame" << std::endl;
+	std::cout << "per character colors: " << perGlyph / count << " ms/frame" << std::endl;
+	return EXIT_SUCCESS;
+}
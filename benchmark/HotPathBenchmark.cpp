@@ -0,0 +1,277 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "VividText.h"
+
+// Times the run table and layout hot paths of VividText on generated documents of growing size:
+// a console log with a few runs per line, syntax highlighted code with a run per token and
+// a rainbow with a run per character. Draws go to a target that only counts what it is handed.
+// Results are printed as comma separated values, one row per benchmark, document and size.
+// Usage: HotPathBenchmark [font file] [largest text size] > results.csv
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Keeps lookups whose results are never used from being optimized away
+	volatile std::size_t lookupSum = 0;
+
+	double nanoseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::nano>(duration).count();
+	}
+
+	struct Span {
+		std::size_t start;
+		sfv::ChunkBuilder chunk;
+	};
+
+	struct Document {
+		std::string name;
+		std::string text;
+		std::vector<Span> spans;
+	};
+
+	void addSpan(Document& document, std::size_t start, std::size_t length, sfv::ChunkBuilder chunk)
+	{
+		chunk.length = length;
+		document.spans.push_back({ start, chunk });
+	}
+
+	Document logDocument(std::size_t characters)
+	{
+		static const char* const levels[] = { "INFO ", "WARN ", "ERROR" };
+		static const sf::Color colors[] = { sf::Color::Green, sf::Color::Yellow, sf::Color::Red };
+		Document document{ "log", std::string(), std::vector<Span>() };
+		for (std::size_t line = 0; document.text.size() < characters; ++line) {
+			const std::size_t level = line % 7 == 6 ? 2 : line % 3 == 2 ? 1 : 0;
+			const std::string stamp = "[" + std::to_string(10000 + line) + "] ";
+			addSpan(document, document.text.size(), stamp.size(), sfv::ChunkBuilder(0U).fill(sf::Color(128, 128, 128)));
+			document.text += stamp;
+			addSpan(document, document.text.size(), 5, sfv::ChunkBuilder(0U).fill(colors[level]).stylize(level == 2 ? sf::Text::Bold : sf::Text::Regular));
+			document.text += levels[level];
+			document.text += " connection " + std::to_string(line * 7919 % 100000) + " accepted from 10.0.0." + std::to_string(line % 256) + "\n";
+		}
+		document.text.resize(characters);
+		return document;
+	}
+
+	Document codeDocument(std::size_t characters)
+	{
+		static const char* const tokens[] = { "for", " ", "(", "auto", " ", "item", " : ", "items", ") {\n\t", "total", " += ", "item", ".", "weight", " * ", "2.5f", ";\n\t", "// carry it over", "\n}\n" };
+		static const sf::Uint32 kinds[] = { 1, 0, 0, 1, 0, 2, 0, 2, 0, 2, 0, 2, 0, 2, 0, 3, 0, 4, 0 };
+		static const sf::Color colors[] = { sf::Color::White, sf::Color(86, 156, 214), sf::Color(156, 220, 254), sf::Color(181, 206, 168), sf::Color(106, 153, 85) };
+		Document document{ "code", std::string(), std::vector<Span>() };
+		for (std::size_t token = 0; document.text.size() < characters; ++token) {
+			const std::size_t index = token % (sizeof(tokens) / sizeof(tokens[0]));
+			const std::string text = tokens[index];
+			sfv::ChunkBuilder chunk(0U);
+			chunk.fill(colors[kinds[index]]);
+			if (kinds[index] == 1) {
+				chunk.stylize(sf::Text::Bold);
+			}
+			else if (kinds[index] == 4) {
+				chunk.stylize(sf::Text::Italic);
+			}
+			addSpan(document, document.text.size(), text.size(), chunk);
+			document.text += text;
+		}
+		document.text.resize(characters);
+		return document;
+	}
+
+	Document colorDocument(std::size_t characters)
+	{
+		Document document{ "colors", std::string(), std::vector<Span>() };
+		for (std::size_t character = 0; character != characters; ++character) {
+			document.text += character % 64 == 63 ? '\n' : static_cast<char>('a' + character % 26);
+			addSpan(document, character, 1, sfv::ChunkBuilder(0U).fill(sf::Color(static_cast<sf::Uint8>(character * 5), static_cast<sf::Uint8>(character * 3), 200)));
+		}
+		return document;
+	}
+
+	void applySpans(sfv::VividText& text, const Document& document)
+	{
+		for (const Span& span : document.spans) {
+			text.setProperties(span.chunk, span.start, span.chunk.length);
+		}
+	}
+
+	void load(sfv::VividText& text, const Document& document)
+	{
+		text.setString(document.text);
+		sfv::VividText::EditScope edit(text);
+		applySpans(text, document);
+	}
+
+	std::size_t runCount(const sfv::VividText& text)
+	{
+		return text.getString().isEmpty() ? 0U : text.getChunkIndex(text.getString().getSize() - 1) + 1;
+	}
+
+	// Render target that never touches OpenGL, the sink counts what would have been drawn
+	class CountingTarget : public sf::RenderTarget {
+	public:
+		sf::Vector2u getSize() const override
+		{
+			return sf::Vector2u(1280U, 720U);
+		}
+	};
+
+	class CountingSink : public sfv::GeometrySink {
+	public:
+		std::size_t drawCalls = 0;
+		std::size_t vertices = 0;
+
+		bool update(Layer, std::size_t, std::size_t, const sf::Vertex*, std::size_t) override
+		{
+			return true;
+		}
+
+		void draw(Layer, sf::RenderTarget&, std::size_t, std::size_t count, const sf::RenderStates&) override
+		{
+			++drawCalls;
+			vertices += count;
+		}
+	};
+
+	struct Result {
+		const char* benchmark;
+		std::size_t operations;
+		double elapsed;
+		std::size_t drawCalls;
+		std::size_t vertices;
+	};
+
+	void print(const Result& result, const Document& document, std::size_t runs)
+	{
+		const double operations = static_cast<double>(result.operations);
+		std::cout << result.benchmark << ',' << document.name << ',' << document.text.size() << ',' << runs << ',' << result.operations << ','
+			<< result.elapsed / operations << ',' << static_cast<double>(result.drawCalls) / operations << ',' << static_cast<double>(result.vertices) / operations << std::endl;
+	}
+
+	void run(const Document& document, const sf::Font& font)
+	{
+		const std::size_t size = document.text.size();
+		const std::size_t repeats = std::max<std::size_t>(3U, 1000000U / size);
+		std::mt19937 random(42U);
+		sfv::VividText text("", font);
+		load(text, document);
+		const std::size_t runs = runCount(text);
+
+		{
+			const Clock::time_point start = Clock::now();
+			for (std::size_t repeat = 0; repeat != repeats; ++repeat) {
+				text.setString(document.text);
+			}
+			print({ "setString", repeats, nanoseconds(Clock::now() - start), 0U, 0U }, document, runs);
+		}
+		{
+			// Every setter splits and merges runs right away
+			text.setString(document.text);
+			const Clock::time_point start = Clock::now();
+			applySpans(text, document);
+			print({ "setProperties", document.spans.size(), nanoseconds(Clock::now() - start), 0U, 0U }, document, runs);
+		}
+		{
+			text.setString(document.text);
+			const Clock::time_point start = Clock::now();
+			{
+				sfv::VividText::EditScope edit(text);
+				applySpans(text, document);
+			}
+			print({ "setProperties_edit", document.spans.size(), nanoseconds(Clock::now() - start), 0U, 0U }, document, runs);
+		}
+		{
+			const std::size_t operations = 1000;
+			const Clock::time_point start = Clock::now();
+			for (std::size_t operation = 0; operation != operations; ++operation) {
+				const std::size_t position = random() % (size - 4);
+				text.setFillColor(sf::Color(static_cast<sf::Uint8>(operation), 0, 0), position, 4);
+			}
+			print({ "setFillColor", operations, nanoseconds(Clock::now() - start), 0U, 0U }, document, runCount(text));
+		}
+		load(text, document);
+		{
+			const std::size_t operations = 1000;
+			const Clock::time_point start = Clock::now();
+			for (std::size_t operation = 0; operation != operations; ++operation) {
+				const std::size_t position = random() % size;
+				text.insert("abc", position);
+				text.erase(position, 3);
+			}
+			print({ "insert_erase", operations, nanoseconds(Clock::now() - start), 0U, 0U }, document, runs);
+		}
+		{
+			const std::size_t operations = 100000;
+			const Clock::time_point start = Clock::now();
+			for (std::size_t operation = 0; operation != operations; ++operation) {
+				lookupSum = lookupSum + text.getChunkIndex(random() % size);
+			}
+			print({ "getChunkIndex", operations, nanoseconds(Clock::now() - start), 0U, 0U }, document, runs);
+		}
+		{
+			double elapsed = 0.0;
+			for (std::size_t repeat = 0; repeat != repeats; ++repeat) {
+				load(text, document);
+				const Clock::time_point start = Clock::now();
+				text.getLocalBounds();
+				elapsed += nanoseconds(Clock::now() - start);
+			}
+			print({ "layout", repeats, elapsed, 0U, 0U }, document, runs);
+		}
+		{
+			// One character typed in the middle, laid out again around it
+			const std::size_t operations = 1000;
+			const Clock::time_point start = Clock::now();
+			for (std::size_t operation = 0; operation != operations; ++operation) {
+				const std::size_t position = random() % size;
+				text.insert("x", position);
+				text.getLocalBounds();
+				text.erase(position, 1);
+				text.getLocalBounds();
+			}
+			print({ "insert_erase_layout", operations, nanoseconds(Clock::now() - start), 0U, 0U }, document, runs);
+		}
+		{
+			CountingTarget target;
+			CountingSink sink;
+			text.setGeometrySink(&sink);
+			target.draw(text);
+			sink.drawCalls = 0;
+			sink.vertices = 0;
+			const std::size_t operations = 200;
+			const Clock::time_point start = Clock::now();
+			for (std::size_t operation = 0; operation != operations; ++operation) {
+				text.setFillColor(sf::Color(static_cast<sf::Uint8>(operation), 255, 0), random() % size, 1);
+				target.draw(text);
+			}
+			print({ "draw", operations, nanoseconds(Clock::now() - start), sink.drawCalls, sink.vertices }, document, runCount(text));
+			text.setGeometrySink(nullptr);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t largest = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cerr << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "benchmark,document,characters,runs,operations,ns_per_operation,draw_calls_per_operation,vertices_per_operation" << std::endl;
+	for (std::size_t size = 1000; size <= largest; size *= 10) {
+		run(logDocument(size), font);
+		run(codeDocument(size), font);
+		run(colorDocument(size), font);
+	}
+	return EXIT_SUCCESS;
+}
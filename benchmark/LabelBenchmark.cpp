@@ -0,0 +1,120 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include "VividText.h"
+
+// Updates a timer label every frame through each setString overload and counts the heap
+// allocations the label makes setting and laying out its text once it was laid out a few times.
+// Building the new text is timed too, but its allocations are left out.
+// Usage: LabelBenchmark [font file] [updates]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	std::size_t allocations = 0;
+	bool counting = false;
+
+	double nanoseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::nano>(duration).count();
+	}
+
+	// Formats into a fixed buffer so the label itself never allocates
+	std::size_t formatTimer(char* buffer, std::size_t size, std::size_t frame)
+	{
+		const int written = std::snprintf(buffer, size, "Time %02zu:%02zu.%03zu  Score %zu", frame / 3600 % 60, frame / 60 % 60, frame % 60 * 16, frame * 7 % 100000);
+		return static_cast<std::size_t>(written);
+	}
+
+	// make builds the text of a frame, set hands it to the label
+	template <typename Make, typename Set>
+	void run(const char* name, sfv::VividText& text, std::size_t updates, Make make, Set set)
+	{
+		// The first updates size the storage of the text and load the glyphs
+		for (std::size_t frame = 0; frame != 64; ++frame) {
+			make(frame);
+			set();
+			text.getLocalBounds();
+		}
+		const std::size_t before = allocations;
+		const Clock::time_point start = Clock::now();
+		for (std::size_t frame = 0; frame != updates; ++frame) {
+			make(frame);
+			counting = true;
+			set();
+			text.getLocalBounds();
+			counting = false;
+		}
+		const double elapsed = nanoseconds(Clock::now() - start);
+		const double count = static_cast<double>(updates);
+		std::cout << name << ": " << elapsed / count << " ns/update, " << static_cast<double>(allocations - before) / count << " allocations/update" << std::endl;
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	allocations += counting ? 1 : 0;
+	if (void* pointer = std::malloc(size != 0 ? size : 1)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t updates = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	char buffer[64];
+	std::size_t length = 0;
+	sfv::VividText text("", font);
+	run("std::string_view", text, updates, [&](std::size_t frame) {
+		length = formatTimer(buffer, sizeof(buffer), frame);
+	}, [&]() {
+		text.setString(std::string_view(buffer, length));
+	});
+
+	char32_t wide[64];
+	run("std::u32string_view", text, updates, [&](std::size_t frame) {
+		length = formatTimer(buffer, sizeof(buffer), frame);
+		std::copy(buffer, buffer + length, wide);
+	}, [&]() {
+		text.setString(std::u32string_view(wide, length));
+	});
+
+	// A new sf::String every frame, handed over or copied
+	sf::String string;
+	run("sf::String&&", text, updates, [&](std::size_t frame) {
+		string = sf::String(std::string(buffer, formatTimer(buffer, sizeof(buffer), frame)));
+	}, [&]() {
+		text.setString(std::move(string));
+	});
+
+	run("const sf::String&", text, updates, [&](std::size_t frame) {
+		string = sf::String(std::string(buffer, formatTimer(buffer, sizeof(buffer), frame)));
+	}, [&]() {
+		text.setString(string);
+	});
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <new>
+#include <string>
+#include "VividText.h"
+
+// Lays out thousands of labels drawn from a few item names and damage numbers, once with every label
+// laying itself out and once sharing their geometry through a LayoutCache. Prints the time to lay all of
+// them out, the time per frame when a tenth of them change, the heap each label takes and the hit rate.
+// Usage: LayoutCacheBenchmark [font file] [labels] [frames]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Heap in use, every block carries its size in front of it
+	std::size_t heapBytes = 0;
+	const std::size_t HEADER = alignof(std::max_align_t);
+
+	double nanoseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::nano>(duration).count();
+	}
+
+	std::string labelText(std::size_t index)
+	{
+		static const char* const names[] = { "Iron Sword", "Healing Potion", "Oak Shield", "Leather Boots", "Mana Crystal", "Old Map", "Silver Ring", "Torch" };
+		if (index % 2 == 0) {
+			return names[index / 2 % 8];
+		}
+		return std::to_string(10 + index * 7 % 40);
+	}
+
+	void run(const char* name, const sf::Font& font, std::size_t labels, std::size_t frames, sfv::LayoutCache* cache)
+	{
+		const std::size_t before = heapBytes;
+		Clock::time_point start = Clock::now();
+		std::deque<sfv::VividText> texts;
+		for (std::size_t index = 0; index != labels; ++index) {
+			texts.emplace_back(labelText(index), font);
+			sfv::VividText& text = texts.back();
+			text.setLayoutCache(cache);
+			text.setOutlineThickness(1.f);
+			text.setFillColor(index % 3 == 0 ? sf::Color::Yellow : sf::Color::White);
+			text.setPosition(static_cast<float>(index % 100) * 20.f, static_cast<float>(index / 100) * 20.f);
+			text.getLocalBounds();
+		}
+		const double first = nanoseconds(Clock::now() - start);
+		const double bytes = static_cast<double>(heapBytes - before) / static_cast<double>(labels);
+
+		start = Clock::now();
+		for (std::size_t frame = 0; frame != frames; ++frame) {
+			for (std::size_t index = frame % 10; index < labels; index += 10) {
+				texts[index].setString(labelText(index + frame));
+				texts[index].getLocalBounds();
+			}
+		}
+		const double perFrame = nanoseconds(Clock::now() - start) / static_cast<double>(frames);
+
+		std::cout << name << ": " << first / 1000000.0 << " ms first layout, " << perFrame / 1000.0 << " us/frame, " << bytes << " bytes/label";
+		if (cache) {
+			const sfv::LayoutCache::Statistics statistics = cache->getStatistics();
+			std::cout << ", hit rate " << cache->getHitRate() << ", " << statistics.entries << " entries in " << statistics.bytes << " bytes";
+		}
+		std::cout << std::endl;
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	if (void* block = std::malloc(size + HEADER)) {
+		*static_cast<std::size_t*>(block) = size;
+		heapBytes += size;
+		return static_cast<char*>(block) + HEADER;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	if (!pointer) {
+		return;
+	}
+	void* block = static_cast<char*>(pointer) - HEADER;
+	heapBytes -= *static_cast<std::size_t*>(block);
+	std::free(block);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t labels = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+	const std::size_t frames = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	run("own layout", font, labels, frames, nullptr);
+	sfv::LayoutCache cache;
+	run("shared layout", font, labels, frames, &cache);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "VividText.h"
+
+// Parses and lays out a marked up document, and compares it with building the same runs
+// from the plain string with one setter call per span.
+// Usage: MarkupBenchmark [font file] [characters] [iterations]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	struct Span {
+		std::size_t start;
+		std::size_t length;
+		int kind;
+	};
+
+	// Every few words get bold, a color or a size, the way a chat log or a help page is marked up
+	void document(std::size_t characters, std::string& markup, std::string& plain, std::vector<Span>& spans)
+	{
+		const char* words[] = { "lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "consectetur ", "adipiscing ", "elit. " };
+		const char* open[] = { "[b]", "[color=#FF8000]", "[size=24]", "[i]" };
+		const char* close[] = { "[/b]", "[/color]", "[/size]", "[/i]" };
+		for (std::size_t word = 0; markup.size() < characters; ++word) {
+			const char* text = word % 40 == 39 ? "\n" : words[word % 8];
+			if (word % 3 == 0) {
+				const int kind = static_cast<int>(word / 3 % 4);
+				spans.push_back({ plain.size(), std::char_traits<char>::length(text), kind });
+				markup += open[kind];
+				markup += text;
+				markup += close[kind];
+			}
+			else {
+				markup += text;
+			}
+			plain += text;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t characters = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10240;
+	const std::size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+	sfv::FontRegistry fonts;
+	fonts.add("main", font);
+
+	std::string markup;
+	std::string plain;
+	std::vector<Span> spans;
+	document(characters, markup, plain, spans);
+	const sf::String markupString(markup);
+	const sf::String plainString(plain);
+
+	sfv::VividText text(sf::String(), font);
+	// Load the glyphs once so both sides only measure parsing and layout
+	text.setMarkup(markupString, fonts);
+	text.getLocalBounds();
+
+	std::cout << "markup: " << markup.size() << " characters, text: " << plain.size() << " characters, spans: " << spans.size() << std::endl;
+
+	double parse = 0.0;
+	double parsed = 0.0;
+	for (std::size_t iteration = 0; iteration != iterations; ++iteration) {
+		const Clock::time_point start = Clock::now();
+		text.setMarkup(markupString, fonts);
+		const Clock::time_point middle = Clock::now();
+		text.getLocalBounds();
+		parse += milliseconds(middle - start);
+		parsed += milliseconds(Clock::now() - start);
+	}
+
+	double setters = 0.0;
+	for (std::size_t iteration = 0; iteration != iterations; ++iteration) {
+		const Clock::time_point start = Clock::now();
+		text.setString(plainString);
+		for (const Span& span : spans) {
+			switch (span.kind) {
+			case 0:
+				text.setStyle(sf::Text::Style::Bold, span.start, span.length);
+				break;
+			case 1:
+				text.setFillColor(sf::Color(255, 128, 0), span.start, span.length);
+				break;
+			case 2:
+				text.setCharacterSize(24, span.start, span.length);
+				break;
+			default:
+				text.setStyle(sf::Text::Style::Italic, span.start, span.length);
+				break;
+			}
+		}
+		text.getLocalBounds();
+		setters += milliseconds(Clock::now() - start);
+	}
+
+	const double count = static_cast<double>(iterations);
+	std::cout << "parse: " << parse / count << " ms" << std::endl;
+	std::cout << "parse and layout: " << parsed / count << " ms" << std::endl;
+	std::cout << "setters and layout: " << setters / count << " ms" << std::endl;
+	return EXIT_SUCCESS;
+}
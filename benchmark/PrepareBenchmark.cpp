@@ -0,0 +1,102 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "VividText.h"
+#include "WorkerPool.h"
+
+// Rebuilds hundreds of dirty labels and a few long paragraphs every frame through VividText::prepare,
+// with pools of one worker up to one per core.
+// Usage: PrepareBenchmark [font file] [label count] [frames]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	std::string paragraph(std::size_t words)
+	{
+		std::string text;
+		for (std::size_t word = 0; word != words; ++word) {
+			text += word % 12 == 11 ? "lorem ipsum\n" : "dolor sit ";
+		}
+		return text;
+	}
+
+	void dirtyAll(std::vector<std::unique_ptr<sfv::VividText>>& texts, std::size_t frame)
+	{
+		for (std::size_t index = 0; index != texts.size(); ++index) {
+			sfv::VividText& text = *texts[index];
+			if (index % 50 == 0) {
+				// Restyling a paragraph lays all of it out again
+				text.setCharacterSize(frame % 2 ? 16 : 17);
+			}
+			else {
+				text.setString("Goblin " + std::to_string(index) + " hits for " + std::to_string(frame * 7 % 1000));
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+	const std::size_t frames = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::unique_ptr<sfv::VividText>> texts;
+	for (std::size_t index = 0; index != count; ++index) {
+		texts.emplace_back(new sfv::VividText(index % 50 == 0 ? paragraph(400) : "Goblin", font));
+		texts.back()->setOutlineThickness(1.f);
+	}
+	std::vector<const sfv::VividText*> list;
+	for (const auto& text : texts) {
+		list.push_back(text.get());
+	}
+
+	// Powers of two up to the core count, and the core count itself
+	const std::size_t cores = std::max(1U, std::thread::hardware_concurrency());
+	std::vector<std::size_t> workerCounts;
+	for (std::size_t workers = 1; workers < cores; workers *= 2) {
+		workerCounts.push_back(workers);
+	}
+	workerCounts.push_back(cores);
+
+	std::cout << "texts: " << count << ", frames: " << frames << std::endl;
+	double single = 0.0;
+	for (std::size_t workers : workerCounts) {
+		sfv::WorkerPool pool(workers);
+
+		// Warm up so glyph loading is not measured
+		dirtyAll(texts, 0);
+		sfv::VividText::prepare(list, pool);
+
+		double total = 0.0;
+		for (std::size_t frame = 1; frame <= frames; ++frame) {
+			dirtyAll(texts, frame);
+			const Clock::time_point start = Clock::now();
+			sfv::VividText::prepare(list, pool);
+			total += milliseconds(Clock::now() - start);
+		}
+		const double perFrame = total / static_cast<double>(frames);
+		if (workers == 1) {
+			single = perFrame;
+		}
+		std::cout << workers << " workers: " << perFrame << " ms/frame, speedup " << single / perFrame << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "VividText.h"
+
+// Scrolls through a long console log a few pixels per frame and appends a line now and then,
+// once with every line laid out and once culled against the view of the target.
+// Usage: ScrollBenchmark [font file] [line count] [frames]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	std::string logLine(std::size_t index)
+	{
+		return "[" + std::to_string(index) + "] Goblin hits the player for " + std::to_string(index * 7 % 100) + " damage\n";
+	}
+
+	double run(sfv::VividText& text, sf::RenderTexture& target, std::size_t lines, std::size_t frames)
+	{
+		sf::View view(sf::FloatRect(0.f, 0.f, 1280.f, 720.f));
+		target.setView(view);
+		target.draw(text);
+
+		const Clock::time_point start = Clock::now();
+		for (std::size_t frame = 1; frame <= frames; ++frame) {
+			if (frame % 30 == 0) {
+				text.insert(logLine(lines + frame), text.getString().getSize());
+			}
+			view.move(0.f, 3.f);
+			target.setView(view);
+			target.draw(text);
+		}
+		return milliseconds(Clock::now() - start) / static_cast<double>(frames);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t lines = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+	const std::size_t frames = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 600;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+	sf::RenderTexture target;
+	target.create(1280, 720);
+
+	std::string log;
+	for (std::size_t index = 0; index != lines; ++index) {
+		log += logLine(index);
+	}
+	std::cout << "lines: " << lines << ", frames: " << frames << std::endl;
+
+	Clock::time_point start = Clock::now();
+	sfv::VividText full(log, font);
+	full.setCharacterSize(16);
+	full.getLocalBounds();
+	std::cout << "full layout: " << milliseconds(Clock::now() - start) << " ms" << std::endl;
+	std::cout << "full: " << run(full, target, lines, frames) << " ms/frame" << std::endl;
+
+	start = Clock::now();
+	sfv::VividText culled(log, font);
+	culled.setCharacterSize(16);
+	culled.setFollowView(true);
+	culled.getLocalBounds();
+	std::cout << "culled layout: " << milliseconds(Clock::now() - start) << " ms" << std::endl;
+	std::cout << "culled: " << run(culled, target, lines, frames) << " ms/frame" << std::endl;
+	return EXIT_SUCCESS;
+}
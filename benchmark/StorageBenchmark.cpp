@@ -0,0 +1,89 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "VividText.h"
+
+// Compares texts keeping their characters as UTF-32 with compact ones, on an English log,
+// a French one holding Latin-1 accents and a Russian one that needs UTF-8.
+// Prints the bytes per character of each, and the time to lay the whole text out,
+// to insert and erase in the middle of it and to read the string back after an edit.
+// Usage: StorageBenchmark [font file] [text size]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double nanoseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::nano>(duration).count();
+	}
+
+	std::u32string makeText(std::u32string_view line, std::size_t characters)
+	{
+		std::u32string text;
+		for (std::size_t index = 0; text.size() < characters; ++index) {
+			text += U"[" + std::u32string(1, static_cast<char32_t>(U'0' + index % 10)) + U"] ";
+			text += line;
+		}
+		text.resize(characters);
+		return text;
+	}
+
+	void run(const char* name, std::u32string_view string, const sf::Font& font, bool compact)
+	{
+		const std::size_t edits = 200;
+		sfv::VividText text("", font);
+		text.setCompactString(compact);
+		text.setMaxWidth(800.f);
+
+		const Clock::time_point start = Clock::now();
+		text.setString(string);
+		text.getLocalBounds();
+		const double layout = nanoseconds(Clock::now() - start);
+
+		const sf::String word("word ");
+		const std::size_t middle = string.size() / 2;
+		Clock::duration editing = Clock::duration::zero();
+		Clock::duration reading = Clock::duration::zero();
+		for (std::size_t edit = 0; edit != edits; ++edit) {
+			const Clock::time_point before = Clock::now();
+			text.insert(word, middle);
+			text.erase(middle, word.getSize());
+			text.getLocalBounds();
+			const Clock::time_point edited = Clock::now();
+			text.getString();
+			reading += Clock::now() - edited;
+			editing += edited - before;
+		}
+
+		// The string getString built from a compact text is freed by the next edit, so it isn't counted
+		std::cout << name << (compact ? " compact" : " UTF-32") << ": "
+			<< static_cast<double>(text.getStringByteSize()) / static_cast<double>(string.size()) << " bytes/character, "
+			<< layout / 1000000.0 << " ms layout, "
+			<< nanoseconds(editing) / 1000.0 / edits << " us/edit, "
+			<< nanoseconds(reading) / 1000.0 / edits << " us/getString" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const std::u32string english = makeText(U"connection accepted from 10.0.0.1, handshake took 12 ms\n", size);
+	const std::u32string french = makeText(U"connexion acceptée depuis 10.0.0.1, négociation terminée en 12 ms\n", size);
+	const std::u32string russian = makeText(U"соединение принято от 10.0.0.1, рукопожатие заняло 12 мс\n", size);
+	for (const bool compact : { false, true }) {
+		run("English", english, font, compact);
+		run("French", french, font, compact);
+		run("Russian", russian, font, compact);
+	}
+	return EXIT_SUCCESS;
+}
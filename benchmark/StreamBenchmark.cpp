@@ -0,0 +1,86 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "VividText.h"
+
+// Appends messages to a long log, with and without a scrollback limit,
+// against laying a text as long as one message out from scratch.
+// Usage: StreamBenchmark [font file] [log length] [message length] [messages]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	std::string message(std::size_t length, std::size_t seed)
+	{
+		std::string string;
+		for (std::size_t character = 0; character + 1 < length; ++character) {
+			string += (character + seed) % 7 == 6 ? ' ' : static_cast<char>('a' + (character + seed) % 26);
+		}
+		return string + '\n';
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t logLength = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+	const std::size_t messageLength = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+	const std::size_t messages = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1000;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::string log;
+	while (log.size() < logLength) {
+		log += message(messageLength, log.size());
+	}
+	const sfv::Chunk style(0U, &font);
+
+	double fresh = 0.0;
+	for (std::size_t index = 0; index != messages; ++index) {
+		const Clock::time_point start = Clock::now();
+		sfv::VividText text(message(messageLength, index), font);
+		text.getLocalBounds();
+		fresh += milliseconds(Clock::now() - start);
+	}
+
+	sfv::VividText unbounded(log, font);
+	unbounded.getLocalBounds();
+	double append = 0.0;
+	for (std::size_t index = 0; index != messages; ++index) {
+		const std::string line = message(messageLength, index);
+		const Clock::time_point start = Clock::now();
+		unbounded.append(line, style);
+		unbounded.getLocalBounds();
+		append += milliseconds(Clock::now() - start);
+	}
+
+	// The log stays about as long as it started
+	sfv::VividText bounded(log, font);
+	bounded.setScrollback(logLength / messageLength);
+	double scrollback = 0.0;
+	for (std::size_t index = 0; index != messages; ++index) {
+		const std::string line = message(messageLength, index);
+		const Clock::time_point start = Clock::now();
+		bounded.append(line, style);
+		bounded.getLocalBounds();
+		scrollback += milliseconds(Clock::now() - start);
+	}
+
+	const double count = static_cast<double>(messages);
+	std::cout << "log: " << logLength << " characters, messages: " << messages << " of " << messageLength << " characters" << std::endl;
+	std::cout << "layout from scratch: " << fresh / count << " ms/message" << std::endl;
+	std::cout << "append: " << append / count << " ms/message" << std::endl;
+	std::cout << "append with scrollback: " << scrollback / count << " ms/message" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "VividText.h"
+
+// Resizes a wrapped text the way dragging a window border does, one width per frame,
+// and compares it with laying the whole text out again at each width.
+// Usage: WrapBenchmark [font file] [characters] [frames]
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	std::string paragraphs(std::size_t characters)
+	{
+		const char* words[] = { "lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "consectetur ", "adipiscing ", "elit. " };
+		std::string text;
+		for (std::size_t word = 0; text.size() < characters; ++word) {
+			text += word % 60 == 59 ? "\n" : words[word % 8];
+		}
+		return text;
+	}
+
+	float width(std::size_t frame)
+	{
+		// Back and forth between 400 and 1000 pixels, a few pixels per frame
+		const std::size_t step = frame % 200;
+		return 400.f + 3.f * static_cast<float>(step < 100 ? step : 200 - step);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string fontFile = argc > 1 ? argv[1] : "consola.ttf";
+	const std::size_t characters = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+	const std::size_t frames = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 400;
+
+	sf::Font font;
+	if (!font.loadFromFile(fontFile)) {
+		std::cout << "Couldn't load " << fontFile << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const std::string string = paragraphs(characters);
+	sfv::VividText text(string, font);
+	text.setMaxWidth(width(0));
+	text.getLocalBounds();
+
+	std::cout << "characters: " << string.size() << ", frames: " << frames << std::endl;
+
+	double rewrap = 0.0;
+	for (std::size_t frame = 1; frame <= frames; ++frame) {
+		const Clock::time_point start = Clock::now();
+		text.setMaxWidth(width(frame));
+		text.getLocalBounds();
+		rewrap += milliseconds(Clock::now() - start);
+	}
+
+	double relayout = 0.0;
+	for (std::size_t frame = 1; frame <= frames; ++frame) {
+		const Clock::time_point start = Clock::now();
+		// Going through zero drops the cached words
+		text.setMaxWidth(0.f);
+		text.setMaxWidth(width(frame));
+		text.getLocalBounds();
+		relayout += milliseconds(Clock::now() - start);
+	}
+
+	std::cout << "rewrap: " << rewrap / static_cast<double>(frames) << " ms/frame" << std::endl;
+	std::cout << "full layout: " << relayout / static_cast<double>(frames) << " ms/frame" << std::endl;
+	return EXIT_SUCCESS;
+}
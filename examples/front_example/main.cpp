@@ -18,7 +18,7 @@ int main()
 
 	sf::Font consola, shadow, running_nightshade;
 	loadFont(consola, "consola.ttf");
-	loadFont(shadow, "shadow.otf");
+	loadFont(shadow, "Shadow.otf");
 	loadFont(running_nightshade, "running_nightshade.ttf");
 
 	sfv::VividText text("This is a single string of vivid text.\nIt can hold different styles, fonts,\nsizes, and colors. It can even\noutline different sections of the\nstring.", consola);
@@ -32,10 +32,11 @@ int main()
 	text.setFont(shadow, 61, 13);
 	text.setCharacterSize(80, 75, 6);
 	text.setFillColor(sf::Color::Cyan, 75, 6);
-	for (std::size_t i = 87; i != 93; ++i) {
-		sf::Color color(rand() % 199 + 57, rand() % 199 + 57, rand() % 199 + 57);
-		text.setFillColor(color, i, 1);
+	sf::Color colors[6];
+	for (sf::Color& color : colors) {
+		color = sf::Color(rand() % 199 + 57, rand() % 199 + 57, rand() % 199 + 57);
 	}
+	text.setGlyphFillColors(colors, 87, 6);
 	text.setOutlineColor(sf::Color::Red, 107, 8);
 	text.setOutlineColor(sf::Color::Blue, 115, 9);
 	text.setOutlineColor(sf::Color::Magenta, 125, 8);
@@ -9,10 +9,7 @@
 namespace sfv {
 
 	struct Chunk {
-		std::size_t index;
 		std::size_t length;
-		std::size_t verticeLength;
-		std::size_t outlineLength;
 		sf::Color fillColor;
 		sf::Color outlineColor;
 		sf::Color lineColor;
@@ -23,7 +20,7 @@ namespace sfv {
 
 		Chunk();
 
-		Chunk(std::size_t index_, std::size_t length_, const sf::Font* font_ = nullptr);
+		Chunk(std::size_t length_, const sf::Font* font_ = nullptr);
 
 		Chunk(const Chunk& chunk) noexcept;
 
@@ -52,6 +49,7 @@ namespace sfv {
 
 		ChunkBuilder(std::size_t length);
 		ChunkBuilder() = default;
+		ChunkBuilder(const ChunkBuilder&) = default;
 		ChunkBuilder(ChunkBuilder&&) = default;
 
 		ChunkBuilder& fill(sf::Color color);
@@ -63,6 +61,9 @@ namespace sfv {
 		ChunkBuilder& fontType(const sf::Font& font_);
 
 		ChunkBuilder& charSize(sf::Uint32 size);
+
+		// Copy the attributes set here over those of chunk, leaving its length alone
+		void apply(Chunk& chunk) const;
 	};
 }
 #endif
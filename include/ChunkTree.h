@@ -0,0 +1,188 @@
+#pragma once
+
+#ifndef SFV_CHUNK_TREE_H
+#define SFV_CHUNK_TREE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Chunk.h"
+#include "StyleTable.h"
+
+namespace sfv {
+
+	// Ordered run container backed by an implicit treap.
+	// Every node caches the number of runs and characters below it, so runs
+	// are found by position or by index in O(log n) and no run stores its
+	// own offset into the string.
+	// Runs keep their attributes in a style table, holding a reference to their style.
+	// A tree has a table of its own unless it is given one to share with other trees.
+	// Nodes are indexed with 32 bits, and lengths and counts take 32 bits too, so a node fits in 32 bytes
+	// and the runs hold fewer than 2^32 characters.
+	class ChunkTree {
+	public:
+		struct Run {
+			std::uint32_t length;
+			StyleTable::Id style;
+		};
+
+	private:
+		typedef std::uint32_t Node;
+
+		static constexpr Node NIL = static_cast<Node>(-1);
+
+		struct NodeData {
+			Run run;
+			Node left;
+			Node right;
+			Node parent;
+			std::uint32_t priority;
+			std::uint32_t count;
+			std::uint32_t sum;
+		};
+
+		std::vector<NodeData> m_nodes;
+		std::vector<Node> m_free;
+		Node m_root;
+		std::uint32_t m_seed;
+		// Table of the runs, the own one is only created once a run needs it
+		mutable StyleTable* m_styles;
+		mutable std::unique_ptr<StyleTable> m_ownStyles;
+	public:
+		// Location of the run holding a character
+		struct Location {
+			std::size_t index;
+			std::size_t start;
+		};
+
+		class const_iterator {
+		private:
+			friend class ChunkTree;
+			const ChunkTree* m_tree;
+			Node m_node;
+
+			const_iterator(const ChunkTree* tree, Node node);
+		public:
+			const Run& operator*() const;
+
+			const Run* operator->() const;
+
+			const_iterator& operator++();
+
+			bool operator==(const const_iterator& other) const;
+
+			bool operator!=(const const_iterator& other) const;
+		};
+
+		// Runs with a style table of their own
+		ChunkTree();
+
+		// Runs sharing the styles of a table with other trees
+		explicit ChunkTree(StyleTable& styles);
+
+		ChunkTree(const ChunkTree& tree);
+
+		ChunkTree(ChunkTree&& tree) noexcept;
+
+		ChunkTree& operator=(const ChunkTree& tree);
+
+		ChunkTree& operator=(ChunkTree&& tree) noexcept;
+
+		~ChunkTree();
+
+		StyleTable& getStyleTable() const;
+
+		// Move every run to the styles of a table shared with other trees
+		void setStyleTable(StyleTable& styles);
+
+		std::size_t size() const;
+
+		std::size_t length() const;
+
+		bool empty() const;
+
+		// Number of runs the node storage holds before it has to grow
+		std::size_t capacity() const;
+
+		const Run& operator[](std::size_t index) const;
+
+		const Run& front() const;
+
+		const Run& back() const;
+
+		// Attributes of a run
+		const Chunk& getStyle(const Run& run) const;
+
+		// Attributes and length of a run
+		Chunk getChunk(std::size_t index) const;
+
+		// Run holding the character at subIndex, index is size() past the end
+		Location find(std::size_t subIndex) const;
+
+		// Index of the first character of a run
+		std::size_t start(std::size_t index) const;
+
+		const_iterator begin() const;
+
+		const_iterator end() const;
+
+		const_iterator at(std::size_t index) const;
+
+		void clear();
+
+		// Replace every run at once, in linear time
+		void assign(const std::vector<Chunk>& chunks);
+
+		// Replace count runs from index with chunks, in time linear in the number of new runs
+		void replace(std::size_t index, std::size_t count, const std::vector<Chunk>& chunks);
+
+		// Same with runs whose styles are in the table of this tree
+		void replace(std::size_t index, std::size_t count, const std::vector<Run>& runs);
+
+		void insert(std::size_t index, const Chunk& chunk);
+
+		void insert(std::size_t index, const Run& run);
+
+		void erase(std::size_t index, std::size_t count = 1);
+
+		// Replace the attributes and length of a run
+		void assign(std::size_t index, const Chunk& chunk);
+
+		// Give a run the attributes set in data over its own
+		void restyle(std::size_t index, const ChunkBuilder& data);
+
+		void resize(std::size_t index, std::size_t length);
+
+	private:
+		// The node takes over the reference to the style of run
+		Node allocate(const Run& run);
+
+		void release(Node node);
+
+		// Release a detached subtree
+		void releaseAll(Node root);
+
+		// Treap holding count runs in order, in linear time, taking a reference to each style
+		Node build(const Chunk* chunks, std::size_t count);
+
+		Node build(const Run* runs, std::size_t count);
+
+		template <typename T, typename Acquire>
+		Node build(const T* items, std::size_t count, Acquire acquire);
+
+		std::size_t count(Node node) const;
+
+		std::size_t sum(Node node) const;
+
+		void pull(Node node);
+
+		void split(Node node, std::size_t index, Node& left, Node& right);
+
+		Node merge(Node left, Node right);
+
+		Node locate(std::size_t index) const;
+
+		void adjust(std::size_t index, std::ptrdiff_t delta);
+	};
+}
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef SFV_FONT_METRICS_H
+#define SFV_FONT_METRICS_H
+
+#include <SFML/Graphics/Font.hpp>
+
+namespace sfv {
+
+	// Everything layout needs to know about a font, without any texture behind it
+	class FontMetrics {
+	public:
+		virtual ~FontMetrics();
+
+		virtual sf::Glyph getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f) = 0;
+
+		virtual float getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize) = 0;
+
+		virtual float getLineSpacing(sf::Uint32 characterSize) = 0;
+
+		virtual float getUnderlinePosition(sf::Uint32 characterSize) = 0;
+
+		virtual float getUnderlineThickness(sf::Uint32 characterSize) = 0;
+	};
+
+	// Metrics of an sf::Font, loading a glyph also rasterizes it into the font texture
+	class SfmlFontMetrics : public FontMetrics {
+	private:
+		const sf::Font* m_font;
+	public:
+		explicit SfmlFontMetrics(const sf::Font& font);
+
+		const sf::Font& getFont() const;
+
+		sf::Glyph getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f) override;
+
+		float getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize) override;
+
+		float getLineSpacing(sf::Uint32 characterSize) override;
+
+		float getUnderlinePosition(sf::Uint32 characterSize) override;
+
+		float getUnderlineThickness(sf::Uint32 characterSize) override;
+	};
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef SFV_FONT_REGISTRY_H
+#define SFV_FONT_REGISTRY_H
+
+#include <SFML/Graphics/Font.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sfv {
+
+	// Fonts markup refers to by name, as in [font=name].
+	// A document only names a handful of fonts, so they are kept in a small array
+	// and looked up straight from the code points of the tag.
+	class FontRegistry {
+	private:
+		std::vector<std::pair<std::string, const sf::Font*>> m_fonts;
+	public:
+		// Registering a name again replaces its font, the font has to outlive the registry
+		void add(const std::string& name, const sf::Font& font);
+
+		void remove(const std::string& name);
+
+		void clear();
+
+		const sf::Font* find(const std::string& name) const;
+
+		// Font named by length code points, nullptr when there is none
+		const sf::Font* find(const sf::Uint32* name, std::size_t length) const;
+	};
+}
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef SFV_FREE_TYPE_FONT_METRICS_H
+#define SFV_FREE_TYPE_FONT_METRICS_H
+
+#include <string>
+#include <vector>
+#include "FontMetrics.h"
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+struct FT_StrokerRec_;
+
+namespace sfv {
+
+	// Font metrics read with FreeType the way sf::Font reads them, without any
+	// texture or graphics context. Glyphs are rendered to find their bounds, their
+	// texture rects have the size of the glyph bitmap but sit at the origin.
+	// Bind it to a font handle with GlyphCache::bind to lay VividText out headless.
+	class FreeTypeFontMetrics : public FontMetrics {
+	private:
+		FT_LibraryRec_* m_library;
+		FT_FaceRec_* m_face;
+		FT_StrokerRec_* m_stroker;
+		std::vector<unsigned char> m_data;
+		sf::Uint32 m_characterSize;
+	public:
+		FreeTypeFontMetrics();
+		FreeTypeFontMetrics(const FreeTypeFontMetrics&) = delete;
+		FreeTypeFontMetrics& operator=(const FreeTypeFontMetrics&) = delete;
+		~FreeTypeFontMetrics();
+
+		bool loadFromFile(const std::string& filename);
+
+		// The data is copied, unlike sf::Font::loadFromMemory
+		bool loadFromMemory(const void* data, std::size_t size);
+
+		sf::Glyph getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f) override;
+
+		float getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize) override;
+
+		float getLineSpacing(sf::Uint32 characterSize) override;
+
+		float getUnderlinePosition(sf::Uint32 characterSize) override;
+
+		float getUnderlineThickness(sf::Uint32 characterSize) override;
+
+	private:
+		bool load();
+
+		bool setCharacterSize(sf::Uint32 characterSize);
+
+		void cleanup();
+	};
+}
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef SFV_GEOMETRY_SINK_H
+#define SFV_GEOMETRY_SINK_H
+
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <vector>
+
+#if SFML_VERSION_MAJOR > 2 || (SFML_VERSION_MAJOR == 2 && SFML_VERSION_MINOR >= 5)
+#include <SFML/Graphics/VertexBuffer.hpp>
+#define SFV_HAS_VERTEX_BUFFER
+#endif
+
+namespace sfv {
+
+	// Destination of the triangles laid out by a VividText.
+	// The text keeps its client side vertices and only hands over the ranges
+	// that changed, right before drawing, so an unchanged text uploads nothing.
+	class GeometrySink {
+	public:
+		enum Layer {
+			Outline,
+			Fill,
+			LayerCount
+		};
+
+		virtual ~GeometrySink();
+
+		// The layer now holds size vertices, the count vertices starting at first changed since the last update.
+		// Return false to be sent the whole layer right away, after losing the previous content.
+		virtual bool update(Layer layer, std::size_t size, std::size_t first, const sf::Vertex* vertices, std::size_t count) = 0;
+
+		// Draw count triangle vertices of the layer starting at first
+		virtual void draw(Layer layer, sf::RenderTarget& target, std::size_t first, std::size_t count, const sf::RenderStates& states) = 0;
+	};
+
+	// Keeps its own copy of the vertices and logs every update, for inspecting what an edit rewrote
+	class RecordingGeometrySink : public GeometrySink {
+	public:
+		struct Upload {
+			Layer layer;
+			std::size_t first;
+			std::size_t count;
+			std::size_t size;
+		};
+
+	private:
+		std::vector<sf::Vertex> m_vertices[LayerCount];
+		std::vector<Upload> m_uploads;
+	public:
+		bool update(Layer layer, std::size_t size, std::size_t first, const sf::Vertex* vertices, std::size_t count) override;
+
+		void draw(Layer layer, sf::RenderTarget& target, std::size_t first, std::size_t count, const sf::RenderStates& states) override;
+
+		const std::vector<sf::Vertex>& getVertices(Layer layer) const;
+
+		const std::vector<Upload>& getUploads() const;
+
+		void clearUploads();
+	};
+
+#ifdef SFV_HAS_VERTEX_BUFFER
+	// Stores the vertices in sf::VertexBuffer objects, re-uploading only the changed ranges.
+	// Buffers grow by half again when they run out of room, which uploads the whole layer.
+	class VertexBufferSink : public GeometrySink {
+	private:
+		sf::VertexBuffer m_buffers[LayerCount];
+		std::size_t m_uploads;
+	public:
+		explicit VertexBufferSink(sf::VertexBuffer::Usage usage = sf::VertexBuffer::Dynamic);
+
+		bool update(Layer layer, std::size_t size, std::size_t first, const sf::Vertex* vertices, std::size_t count) override;
+
+		void draw(Layer layer, sf::RenderTarget& target, std::size_t first, std::size_t count, const sf::RenderStates& states) override;
+
+		const sf::VertexBuffer& getBuffer(Layer layer) const;
+
+		// Number of sf::VertexBuffer::update calls made so far
+		std::size_t getUploadCount() const;
+	};
+#endif
+}
+#endif
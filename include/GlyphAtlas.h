@@ -0,0 +1,91 @@
+#pragma once
+
+#ifndef SFV_GLYPH_ATLAS_H
+#define SFV_GLYPH_ATLAS_H
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace sfv {
+
+	// Texture pages holding copies of glyphs from any number of fonts and sizes,
+	// so text mixing them can be drawn from a single texture.
+	// Packing works on sf::Image, pages are only uploaded when they are drawn.
+	// Like the pages of sf::Font, every page starts with a 2x2 white block used by lines and is smooth.
+	class GlyphAtlas {
+	private:
+		struct Row {
+			unsigned int top;
+			unsigned int width;
+			unsigned int height;
+		};
+
+		struct Page {
+			sf::Image image;
+			// Only created on the first upload, so packing needs no graphics context
+			std::unique_ptr<sf::Texture> texture;
+			std::vector<Row> rows;
+			unsigned int nextRow;
+			bool dirty;
+		};
+
+		// Snapshot of a source texture, refreshed when its generation changes
+		struct Source {
+			sf::Image image;
+			std::size_t generation;
+		};
+
+		struct Key {
+			const void* source;
+			sf::IntRect rect;
+
+			bool operator==(const Key& key) const;
+		};
+
+		struct KeyHash {
+			std::size_t operator()(const Key& key) const;
+		};
+
+		struct Placement {
+			std::size_t page;
+			sf::IntRect rect;
+		};
+
+		unsigned int m_pageSize;
+		std::vector<std::unique_ptr<Page>> m_pages;
+		std::unordered_map<Key, Placement, KeyHash> m_placements;
+		std::unordered_map<const sf::Texture*, Source> m_sources;
+	public:
+		explicit GlyphAtlas(unsigned int pageSize = 2048);
+
+		// Place every rect of source on one page and write where they ended up.
+		// Rects already on the last page are reused, the others are copied from source.
+		// Returns the page index, or -1 if a rect can't fit on an empty page.
+		std::size_t insert(const void* sourceId, const sf::Image& source, const sf::IntRect* rects, std::size_t count, sf::IntRect* placed);
+
+		// Same as above, reading the pixels back from a texture. The copy is only
+		// refreshed when a rect is missing and generation or the texture size changed since the last read.
+		std::size_t insert(const sf::Texture& source, std::size_t generation, const sf::IntRect* rects, std::size_t count, sf::IntRect* placed);
+
+		std::size_t getPageCount() const;
+
+		unsigned int getPageSize() const;
+
+		const sf::Image& getImage(std::size_t page) const;
+
+		// Texture of a page, uploading it first if glyphs were added
+		const sf::Texture& getTexture(std::size_t page) const;
+
+		// Drop every page, the texts using the atlas must be laid out again
+		void clear();
+
+	private:
+		Page& addPage();
+
+		bool pack(Page& page, unsigned int width, unsigned int height, sf::Vector2u& position);
+	};
+}
+#endif
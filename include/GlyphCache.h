@@ -0,0 +1,124 @@
+#pragma once
+
+#ifndef SFV_GLYPH_CACHE_H
+#define SFV_GLYPH_CACHE_H
+
+#include <SFML/Graphics/Font.hpp>
+#include <bitset>
+#include <memory>
+#include <vector>
+#include "FontMetrics.h"
+
+namespace sfv {
+
+	// Flat cache of glyph metrics, kerning pairs and size metrics in front of one font.
+	// Every VividText using the same font shares the same cache. Fonts read their
+	// metrics from the sf::Font itself unless other metrics were bound to them.
+	class GlyphCache {
+	public:
+		struct Statistics {
+			std::size_t glyphHits;
+			std::size_t glyphMisses;
+			std::size_t kerningHits;
+			std::size_t kerningMisses;
+		};
+
+		struct SizeMetrics {
+			sf::Uint32 characterSize;
+			float lineSpacing;
+			float underlinePosition;
+			float underlineThickness;
+		};
+
+	private:
+		// Glyphs of one character size, style and outline thickness
+		struct Face {
+			sf::Uint32 characterSize;
+			bool bold;
+			float outlineThickness;
+			std::bitset<256> loaded;
+			std::vector<sf::Glyph> latin;
+			std::vector<sf::Uint32> keys;
+			std::vector<sf::Glyph> glyphs;
+			std::size_t count;
+		};
+
+		FontMetrics* m_metrics;
+		std::unique_ptr<FontMetrics> m_ownedMetrics;
+		std::vector<Face> m_faces;
+		std::size_t m_lastFace;
+		std::vector<SizeMetrics> m_sizes;
+		std::vector<sf::Uint64> m_kerningKeys;
+		std::vector<float> m_kerningValues;
+		std::size_t m_kerningCount;
+		std::size_t m_generation;
+		Statistics m_statistics;
+
+		GlyphCache(FontMetrics& metrics, std::unique_ptr<FontMetrics> ownedMetrics);
+	public:
+		// Shared cache of a font, created on first use
+		static GlyphCache& get(const sf::Font& font);
+
+		// Lay a font out with other metrics, e.g. read by FreeType on a machine without a GPU.
+		// The font is only used as a handle and never has to be loaded, its texture is never read either.
+		static GlyphCache& bind(const sf::Font& font, FontMetrics& metrics);
+
+		// Forget a font, call it before the font is reloaded or destroyed
+		static void release(const sf::Font& font);
+
+		// Statistics summed over every cached font
+		static Statistics getTotalStatistics();
+
+		// Cache of a font, or nullptr when it has none yet. Like the find functions below it changes nothing,
+		// so several threads can look metrics up at once as long as no thread loads, binds, releases or clears any.
+		static const GlyphCache* find(const sf::Font& font);
+
+		// Texture the glyphs of a font are drawn from, nullptr when the font is bound to other metrics
+		static const sf::Texture* getTexture(const sf::Font& font, sf::Uint32 characterSize);
+
+		FontMetrics& getMetrics() const;
+
+		sf::Glyph getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f);
+
+		float getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize);
+
+		float getLineSpacing(sf::Uint32 characterSize);
+
+		float getUnderlinePosition(sf::Uint32 characterSize);
+
+		float getUnderlineThickness(sf::Uint32 characterSize);
+
+		// Cached metrics, nullptr when they were never loaded. The font is never read.
+		const sf::Glyph* findGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f) const;
+
+		const float* findKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize) const;
+
+		const SizeMetrics* findSizeMetrics(sf::Uint32 characterSize) const;
+
+		// Bumped every time a glyph is loaded from the font, so copies of its textures can tell they are stale
+		std::size_t getGeneration() const;
+
+		const Statistics& getStatistics() const;
+
+		void resetStatistics();
+
+		void clear();
+
+	private:
+		Face& getFace(sf::Uint32 characterSize, bool bold, float outlineThickness);
+
+		// Index of a face, or the face count when it was never loaded
+		std::size_t findFace(sf::Uint32 characterSize, bool bold, float outlineThickness) const;
+
+		const sf::Glyph* findGlyph(const Face& face, sf::Uint32 codePoint) const;
+
+		const float* findKerning(sf::Uint64 key) const;
+
+		SizeMetrics getSizeMetrics(sf::Uint32 characterSize);
+
+		void growGlyphs(Face& face);
+
+		void growKerning();
+	};
+}
+#endif
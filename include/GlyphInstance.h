@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef SFV_GLYPH_INSTANCE_H
+#define SFV_GLYPH_INSTANCE_H
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <vector>
+
+namespace sfv {
+
+	// Size of a quad and the part of the texture it shows, shared by every quad of the same glyph
+	struct GlyphShape {
+		sf::Vector2f size;
+		sf::IntRect textureRect;
+
+		bool operator==(const GlyphShape& shape) const;
+	};
+
+	// One quad of text: 20 bytes, where six sf::Vertex take 120.
+	// The bottom edge is moved left by shear times the height for italic glyphs.
+	struct GlyphInstance {
+		sf::Vector2f position;
+		sf::Uint32 shape;
+		sf::Color color;
+		float shear;
+	};
+
+	// Interned shapes, indexed by GlyphInstance::shape
+	class GlyphShapeTable {
+	private:
+		struct Hash {
+			std::size_t operator()(const GlyphShape& shape) const;
+		};
+
+		std::vector<GlyphShape> m_shapes;
+		// Open addressing from the hash of a shape to its index, cleared without giving its storage back
+		std::vector<sf::Uint32> m_slots;
+	public:
+		sf::Uint32 intern(const GlyphShape& shape);
+
+		const GlyphShape& operator[](sf::Uint32 index) const;
+
+		std::size_t size() const;
+
+		// Bytes held by the shapes and their slots
+		std::size_t getByteSize() const;
+
+		void clear();
+
+	private:
+		void grow();
+	};
+
+	// Append the two triangles of a quad, in the order sf::Text uses
+	void appendTriangles(const GlyphInstance& instance, const GlyphShape& shape, std::vector<sf::Vertex>& vertices);
+
+	// Append the four corners of a quad: top left, top right, bottom left, bottom right
+	void appendQuad(const GlyphInstance& instance, const GlyphShape& shape, std::vector<sf::Vertex>& vertices);
+
+	// Indices drawing quads written by appendQuad as triangles.
+	// The buffer is shared and only grows, it holds at least quadCount quads.
+	const std::vector<sf::Uint32>& getQuadIndices(std::size_t quadCount);
+}
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#ifndef SFV_LAYOUT_CACHE_H
+#define SFV_LAYOUT_CACHE_H
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Chunk.h"
+#include "ChunkTree.h"
+#include "TextLayout.h"
+#include "TextStorage.h"
+
+namespace sfv {
+
+	// Geometry of laid out texts, shared by every text with the same characters, runs and maximum width,
+	// so repeated labels are laid out and stored once and only differ by their transform.
+	// Entries never change once added and are reference counted, a text keeps its own after it was evicted.
+	// The least recently used entries go once the cache holds more bytes than its capacity.
+	// Fonts are told apart by address only, so clear the cache when one is reloaded or destroyed.
+	// A miss loads glyphs and textures from the fonts, so like them the cache is only used from the thread
+	// drawing the texts.
+	class LayoutCache {
+	public:
+		// Lines, pen positions and quads of a text, the segments pointing at their textures
+		typedef std::shared_ptr<const TextLayout::Result> Geometry;
+
+		struct Statistics {
+			std::size_t hits;
+			std::size_t misses;
+			std::size_t evictions;
+			// Entries held, and the bytes they take with their keys
+			std::size_t entries;
+			std::size_t bytes;
+		};
+
+	private:
+		struct Entry {
+			std::size_t hash;
+			float maxWidth;
+			std::vector<sf::Uint32> characters;
+			// Attributes and length of each run
+			std::vector<Chunk> runs;
+			Geometry geometry;
+			std::size_t bytes;
+		};
+
+		// Most recently used first
+		std::list<Entry> m_entries;
+		std::unordered_multimap<std::size_t, std::list<Entry>::iterator> m_lookup;
+		std::size_t m_capacity;
+		Statistics m_statistics;
+	public:
+		explicit LayoutCache(std::size_t capacity = 8U << 20);
+
+		LayoutCache(const LayoutCache&) = delete;
+		LayoutCache& operator=(const LayoutCache&) = delete;
+
+		// Cache of the whole process, see VividText::setLayoutCache
+		static LayoutCache& getDefault();
+
+		// Evict entries until they take at most bytes
+		void setCapacity(std::size_t bytes);
+
+		std::size_t getCapacity() const;
+
+		// Geometry of string with the runs of chunks, laid out and added on a miss
+		Geometry get(const TextStorage& string, const ChunkTree& chunks, float maxWidth);
+
+		void clear();
+
+		Statistics getStatistics() const;
+
+		// Share of the lookups that were hits, zero before the first one
+		float getHitRate() const;
+
+		// Zero the hits, misses and evictions, the entries stay
+		void resetStatistics();
+
+	private:
+		static std::size_t hash(const TextStorage& string, const ChunkTree& chunks, float maxWidth);
+
+		static bool matches(const Entry& entry, const TextStorage& string, const ChunkTree& chunks, float maxWidth);
+
+		// Drop the least recently used entries past the capacity
+		void evict();
+	};
+}
+#endif
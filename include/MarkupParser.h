@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef SFV_MARKUP_PARSER_H
+#define SFV_MARKUP_PARSER_H
+
+#include <SFML/System/String.hpp>
+#include <string>
+#include <vector>
+#include "Chunk.h"
+#include "FontRegistry.h"
+
+namespace sfv {
+
+	// Turns tagged text into its plain string and runs in a single pass.
+	//   [b] [i] [u] [s]                 bold, italic, underlined, strike through
+	//   [color=#RRGGBB] [color=red]     fill color, #RRGGBBAA and the sf::Color names work too
+	//   [outline=#RRGGBB,2]             outline color and an optional thickness
+	//   [size=24]                       character size
+	//   [font=name]                     font registered under name
+	// Each tag is closed by [/b], [/color] and so on, which also closes the tags opened after it.
+	// [[ is a literal bracket, and a tag that isn't understood stays in the text as it is.
+	// Plain text is copied a whole span at a time and runs are only appended when the attributes
+	// change, so the buffers are the only allocations and they are kept from one parse to the next.
+	class MarkupParser {
+	private:
+		enum Tag {
+			Bold,
+			Italic,
+			Underlined,
+			StrikeThrough,
+			Color,
+			Outline,
+			Size,
+			Font
+		};
+
+		// Tag still open and the attributes it replaced
+		struct Open {
+			Tag tag;
+			Chunk previous;
+		};
+
+		std::vector<Open> m_open;
+		std::basic_string<sf::Uint32> m_text;
+		std::vector<Chunk> m_chunks;
+		Chunk m_current;
+	public:
+		// Parse markup, starting with the attributes of base
+		void parse(const sf::String& markup, const FontRegistry& fonts, const Chunk& base);
+
+		const std::basic_string<sf::Uint32>& getText() const;
+
+		// Runs covering the text, without empty runs or neighbours with the same attributes
+		const std::vector<Chunk>& getChunks() const;
+
+	private:
+		// Apply the tag between begin and end, false when it isn't one
+		bool applyTag(const sf::Uint32* begin, const sf::Uint32* end, const FontRegistry& fonts);
+
+		void closeTag(Tag tag);
+
+		// End the current run before its attributes change
+		void flush();
+	};
+}
+#endif
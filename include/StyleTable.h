@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef SFV_STYLE_TABLE_H
+#define SFV_STYLE_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "Chunk.h"
+
+namespace sfv {
+
+	// Deduplicated attribute sets of runs, so a run only stores its length and the id of its style,
+	// and two runs share their attributes when their ids are equal. Styles are compared like chunks,
+	// their lengths are ignored. Every id handed out holds a reference, and the style of the last
+	// reference released is recycled. Every text has a table of its own unless it is given one to share.
+	// A table is not thread safe, texts sharing one must not be edited from several threads at once.
+	class StyleTable {
+	public:
+		typedef std::uint32_t Id;
+
+	private:
+		std::vector<Chunk> m_styles;
+		std::vector<std::size_t> m_hashes;
+		std::vector<std::size_t> m_references;
+		std::vector<Id> m_free;
+		// Open addressing from the hash of a style to its id
+		std::vector<Id> m_slots;
+		std::size_t m_count;
+	public:
+		StyleTable();
+
+		StyleTable(const StyleTable&) = delete;
+		StyleTable& operator=(const StyleTable&) = delete;
+
+		// Table of the whole process, for texts to share with VividText::setStyleTable
+		static StyleTable& getDefault();
+
+		// Id of the attributes of chunk, adding them the first time
+		Id acquire(const Chunk& chunk);
+
+		// Id of the style of id with the attributes set in data over its own
+		Id derive(Id id, const ChunkBuilder& data);
+
+		// Take another reference to a style
+		void retain(Id id);
+
+		void release(Id id);
+
+		// Attributes of a style, with a length of zero
+		const Chunk& operator[](Id id) const;
+
+		// Number of styles in use
+		std::size_t size() const;
+
+		// Hash of the attributes of chunk, the same for chunks comparing equal
+		static std::size_t hash(const Chunk& chunk);
+
+	private:
+		void grow();
+
+		// Remove the slot of a style, moving the styles probed past it back
+		void erase(std::size_t slot);
+	};
+}
+#endif
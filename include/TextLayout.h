@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef SFV_TEXT_LAYOUT_H
+#define SFV_TEXT_LAYOUT_H
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/String.hpp>
+#include <atomic>
+#include <vector>
+#include "ChunkTree.h"
+#include "GlyphInstance.h"
+#include "TextStorage.h"
+#include "WorkerPool.h"
+
+namespace sfv {
+
+	// Turns a string and its runs into lines and glyph quads.
+	// Fonts are only read through their GlyphCache, so layout never touches a texture
+	// and runs without a graphics context once metrics are bound to the fonts.
+	// Layout given a miss flag only finds metrics already in the caches, so it can run on several threads
+	// at once: it never reads a font, and a metric missing from a cache reads as zero and sets the flag.
+	// Paragraphs, the '\n' terminated parts of the string, are laid out independently of each other
+	// and wrap into several lines when they are wider than the maximum width.
+	class TextLayout {
+	public:
+		// Geometry of one line, a paragraph or the part of it that fits on a row
+		struct Line {
+			std::size_t start;
+			std::size_t length;
+			std::size_t instanceBegin;
+			std::size_t outlineBegin;
+			std::size_t segmentBegin;
+			std::size_t wordBegin;
+			sf::Uint32 characterSize;
+			float height;
+			float y;
+			// Pen position past the last character
+			float advance;
+			float minSize;
+			float minX;
+			float minY;
+			float maxX;
+			float maxY;
+		};
+
+		// Run of quads inside a line sharing the same font and size.
+		// Layout leaves texture empty, it belongs to whoever draws the quads.
+		struct Segment {
+			const sf::Font* font;
+			const sf::Texture* texture;
+			sf::Uint32 characterSize;
+			std::size_t offset;
+			std::size_t length;
+			std::size_t instanceCount;
+			std::size_t outlineCount;
+		};
+
+		// Characters up to the end of the whitespace following them, the unit lines wrap at.
+		// The advances include kerning, so the width of a line is the sum of its words.
+		struct Word {
+			std::size_t length;
+			float advance;
+			float whitespace;
+		};
+
+		// Character under a point, trailing when the point is on its right half so a caret goes after it
+		struct Hit {
+			std::size_t index;
+			std::size_t line;
+			bool trailing;
+		};
+
+		// Attributes of each character taking over from those of its run, indexed like the string.
+		// Underlines and strike throughs keep the colors of their run, and offsets only move the quads.
+		struct GlyphAttributes {
+			const sf::Color* fillColors;
+			const sf::Color* outlineColors;
+			const sf::Vector2f* offsets;
+		};
+
+		struct Result {
+			std::vector<Line> lines;
+			std::vector<Word> words;
+			// Pen position of every character inside its line
+			std::vector<float> offsets;
+			std::vector<GlyphInstance> instances;
+			std::vector<GlyphInstance> outlineInstances;
+			std::vector<Segment> segments;
+			GlyphShapeTable shapes;
+			sf::FloatRect bounds;
+		};
+
+	private:
+		const TextStorage& m_string;
+		const ChunkTree& m_chunks;
+		float m_maxWidth;
+		GlyphAttributes m_glyphs;
+		std::atomic<bool>* m_missed;
+	public:
+		// A maximum width of zero never wraps
+		TextLayout(const TextStorage& string, const ChunkTree& chunks, float maxWidth = 0.f, const GlyphAttributes& glyphs = GlyphAttributes(), std::atomic<bool>* missed = nullptr);
+
+		// Lay every line out, replacing the content of result.
+		// A pool lays paragraphs out on its workers, see layoutLines.
+		void layout(Result& result, WorkerPool* pool = nullptr) const;
+
+		// Find the end of the line starting at line.start and the size of its tallest run.
+		// The line ends at the end of its paragraph, or after maxLength characters.
+		void measureLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::size_t maxLength = static_cast<std::size_t>(-1)) const;
+
+		// Measure the lines of the paragraph starting at start, appending its words when wrapping
+		void measureParagraph(std::size_t start, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::vector<Line>& lines, std::vector<Word>& words) const;
+
+		// Append the words of the paragraph starting at start
+		void measureWords(std::size_t start, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::vector<Word>& words) const;
+
+		// Break the count words of the paragraph starting at start into measured lines.
+		// Only a word wider than the maximum width on its own makes a line overflow.
+		void measureLines(std::size_t start, const Word* words, std::size_t count, std::size_t wordBegin, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::vector<Line>& lines) const;
+
+		// Load every metric read while laying out the paragraphs in [start, end) into the glyph caches,
+		// whichever lines they wrap into, so layout given a miss flag finds all of them.
+		// start has to begin a paragraph and end has to be past a newline or the end of the string.
+		void warm(std::size_t start, std::size_t end) const;
+
+		// Append the quads of a measured line whose baseline is set.
+		// The pen position of each character goes to offsets when given, starting with the first one of the line.
+		void layoutLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, GlyphShapeTable& shapes, std::vector<GlyphInstance>& instances, std::vector<GlyphInstance>& outlineInstances, std::vector<Segment>& segments, float* offsets = nullptr) const;
+
+		// Only compute the bounds layoutLine would give the line, leaving it without quads
+		void boundLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, float* offsets = nullptr) const;
+
+		// Lay the paragraphs starting at each of starts out one after the other, the first one below previous
+		// or at the top without one. A pool measures and lays paragraphs out on its workers, only the baselines
+		// are chained on the calling thread, so the result is the same as with a single pass.
+		// The pen positions of the characters of the paragraphs are appended to offsets.
+		// The workers only find metrics, see warm. Should one miss, the paragraphs are laid out again on the calling thread.
+		void layoutLines(const std::vector<std::size_t>& starts, const Line* previous, WorkerPool* pool, GlyphShapeTable& shapes, std::vector<Line>& lines, std::vector<GlyphInstance>& instances, std::vector<GlyphInstance>& outlineInstances, std::vector<Segment>& segments, std::vector<Word>& words, std::vector<float>& offsets) const;
+
+		// Same as layoutLines, but the lines only get their bounds, see boundLine
+		void boundLines(const std::vector<std::size_t>& starts, const Line* previous, WorkerPool* pool, std::vector<Line>& lines, std::vector<Word>& words, std::vector<float>& offsets) const;
+
+		// Top left corner of a character, found from the lines and pen positions of the current string
+		sf::Vector2f findCharacterPos(const std::vector<Line>& lines, const std::vector<float>& offsets, std::size_t subIndex) const;
+
+		// Character under a point, the closest line and character when the point is outside of them.
+		// A newline is never hit, the point hits the character before it on its trailing side.
+		Hit findCharacter(const std::vector<Line>& lines, const std::vector<float>& offsets, sf::Vector2f point) const;
+
+		// Vertical distance between the baselines of two consecutive lines
+		static float lineAdvance(float previousHeight, float height);
+
+		// Baseline of a line following previous, or the first line without one
+		static float baseline(const Line* previous, const Line& line);
+
+		static sf::FloatRect getBounds(const std::vector<Line>& lines);
+
+	private:
+		// Quads only go to the arrays that are given
+		void placeLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, GlyphShapeTable* shapes, std::vector<GlyphInstance>* instances, std::vector<GlyphInstance>* outlineInstances, std::vector<Segment>* segments, float* offsets) const;
+
+		void placeLines(const std::vector<std::size_t>& starts, const Line* previous, WorkerPool* pool, GlyphShapeTable* shapes, std::vector<Line>& lines, std::vector<GlyphInstance>* instances, std::vector<GlyphInstance>* outlineInstances, std::vector<Segment>* segments, std::vector<Word>& words, std::vector<float>& offsets) const;
+	};
+}
+#endif
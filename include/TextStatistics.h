@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef SFV_TEXT_STATISTICS_H
+#define SFV_TEXT_STATISTICS_H
+
+#include <cstddef>
+
+namespace sfv {
+
+	// What texts did since their counters were last reset, see VividText::getStatistics.
+	// Only counted when the library is built with SFV_STATISTICS defined, every counter stays zero otherwise.
+	struct TextStatistics {
+		// Passes laying edited lines out, breaking lines at a new width and laying out the lines around a moved viewport
+		std::size_t layouts;
+		std::size_t rewraps;
+		std::size_t windowLayouts;
+		// Time spent in those passes
+		std::size_t layoutNanoseconds;
+		// Glyph cache lookups made by the passes, except those on the workers of VividText::prepare
+		std::size_t glyphLookups;
+		std::size_t kerningLookups;
+		// Glyph quads laid out, and the vertices they were expanded into for targets and sinks
+		std::size_t quads;
+		std::size_t vertices;
+		std::size_t chunkSplits;
+		std::size_t chunkMerges;
+		// Times the quad arrays or the run table had to move to a larger block
+		std::size_t instanceReallocations;
+		std::size_t chunkReallocations;
+		// Calls to draw, and the draw calls they made on their targets
+		std::size_t draws;
+		std::size_t drawCalls;
+	};
+
+	// Lets an external profiler time the zones VividText goes through: layout, rewrap, cull, resolve, edit, draw and prepare.
+	// begin gets the name of the zone and returns a handle end is called with once the zone is left.
+	// The workers of VividText::prepare go through zones too, so both have to be thread safe.
+	struct ProfilerHooks {
+		void* (*begin)(const char* zone);
+		void (*end)(void* handle);
+	};
+}
+#endif
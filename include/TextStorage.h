@@ -0,0 +1,133 @@
+#pragma once
+
+#ifndef SFV_TEXT_STORAGE_H
+#define SFV_TEXT_STORAGE_H
+
+#include <SFML/System/String.hpp>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sfv {
+
+	// Characters of a text, as UTF-32 or, once compact, as Latin-1 while every character fits in a byte
+	// and as UTF-8 past that. UTF-8 keeps the byte offset of a character at most every STRIDE characters,
+	// so finding one decodes fewer than STRIDE others, and iterators decode the characters one after the other.
+	// Edits move the offsets past them and only look for new ones around the characters they changed.
+	// A compact text only builds its UTF-32 string when asked for it, and frees it again with the next change.
+	class TextStorage {
+	public:
+		enum Encoding {
+			Utf32,
+			Latin1,
+			Utf8
+		};
+
+		class const_iterator {
+		private:
+			friend class TextStorage;
+			const TextStorage* m_storage;
+			std::size_t m_index;
+			// Offset of the character in the bytes of a compact text
+			std::size_t m_byte;
+
+			const_iterator(const TextStorage* storage, std::size_t index, std::size_t byte);
+		public:
+			sf::Uint32 operator*() const;
+
+			const_iterator& operator++();
+
+			// Index of the character in the text
+			std::size_t getIndex() const;
+
+			bool operator==(const const_iterator& other) const;
+
+			bool operator!=(const const_iterator& other) const;
+		};
+
+	private:
+		static const std::size_t STRIDE = 128;
+
+		struct Checkpoint {
+			std::size_t character;
+			std::size_t byte;
+		};
+
+		Encoding m_encoding;
+		// Characters of a UTF-32 text, or the string built from a compact one
+		mutable sf::String m_string;
+		mutable bool m_stale;
+		std::string m_bytes;
+		// Characters of a UTF-8 text whose byte offset is known, in order
+		std::vector<Checkpoint> m_checkpoints;
+		std::size_t m_size;
+	public:
+		TextStorage();
+
+		explicit TextStorage(const sf::String& string);
+
+		// Keep the characters as Latin-1 or UTF-8 from now on, or as UTF-32 again
+		void setCompact(bool compact);
+
+		bool isCompact() const;
+
+		Encoding getEncoding() const;
+
+		// Bytes the characters take, without the string built from a compact text
+		std::size_t getByteSize() const;
+
+		std::size_t getSize() const;
+
+		bool isEmpty() const;
+
+		sf::Uint32 operator[](std::size_t index) const;
+
+		// Index of the first occurrence of character in [start, end), or end
+		std::size_t find(sf::Uint32 character, std::size_t start, std::size_t end) const;
+
+		const_iterator begin() const;
+
+		const_iterator end() const;
+
+		const_iterator at(std::size_t index) const;
+
+		const sf::String& toString() const;
+
+		// Every assignment writes over the storage already held, and only allocates when it has to grow
+		void assign(const sf::String& string);
+
+		void assign(sf::String&& string);
+
+		void assign(std::u32string_view string);
+
+		// Invalid sequences become U+FFFD
+		void assign(std::string_view utf8);
+
+		void insert(std::size_t index, const sf::String& string);
+
+		void erase(std::size_t index, std::size_t count);
+
+	private:
+		std::size_t byteOffset(std::size_t index) const;
+
+		// Start over with an empty compact text, appending characters with push
+		void reset();
+
+		// Free the string built from a compact text, which no longer matches its characters
+		void dropString();
+
+		void push(sf::Uint32 character);
+
+		// Turn Latin-1 into UTF-8, once a character does not fit in a byte anymore
+		void widen();
+
+		// Move the checkpoints past count characters at index replaced with others taking bytes more bytes,
+		// and fill the gap around them
+		void reindex(std::size_t index, std::size_t count, std::ptrdiff_t characters, std::ptrdiff_t bytes);
+
+		// Offset of the character count characters past the one starting at byte, which has to exist
+		std::size_t skip(std::size_t byte, std::size_t count) const;
+	};
+}
+#endif
@@ -3,24 +3,122 @@
 #ifndef SFV_SMART_TEXT_H
 #define SFV_SMART_TEXT_H
 
-#include <SFML\Graphics\Text.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <atomic>
+#include <string>
+#include <string_view>
 #include <vector>
 #include "Chunk.h"
+#include "ChunkTree.h"
+#include "FontRegistry.h"
+#include "GeometrySink.h"
+#include "GlyphAtlas.h"
+#include "GlyphInstance.h"
+#include "LayoutCache.h"
+#include "TextLayout.h"
+#include "TextStatistics.h"
+#include "TextStorage.h"
+#include "WorkerPool.h"
 
 namespace sfv {
 	class VividText : public sf::Drawable, public sf::Transformable
 	{
 	private:
+		friend class VividTextBatch;
+
+		typedef TextLayout::Line Line;
+		typedef TextLayout::Segment Segment;
+
+		// Attribute change queued by an edit, over [start, end) of the text as it was when it was made
+		struct PendingEdit {
+			std::size_t start;
+			std::size_t end;
+			// Number of inserts and erases made before it
+			std::size_t shift;
+			ChunkBuilder chunk;
+		};
+
+		// Insert or erase made during an edit
+		struct PendingShift {
+			std::size_t start;
+			std::size_t removed;
+			std::size_t inserted;
+		};
+
+		// Part of a queued change over [start, end) of the current text
+		struct Fragment {
+			std::size_t start;
+			std::size_t end;
+			std::size_t edit;
+		};
+
 		//Deque for text objects and one whole string
 		//Deque for text Data objects to hold information and one whole vertex array
 		mutable bool m_needsUpdate;
+		mutable bool m_needsRewrap;
+		mutable std::size_t m_revision;
+		mutable std::size_t m_dirtyStart;
+		mutable std::size_t m_dirtyEnd;
+		mutable std::ptrdiff_t m_dirtyDelta;
 		const sf::Font* m_font;
-		sf::String m_string;
+		GlyphAtlas* m_atlas;
+		GeometrySink* m_sink;
+		WorkerPool* m_pool;
+		LayoutCache* m_cache;
+		// Geometry drawn in place of the arrays of the text while it comes from the layout cache
+		mutable LayoutCache::Geometry m_shared;
+		float m_maxWidth;
+		mutable sf::FloatRect m_viewport;
+		bool m_followView;
+		mutable std::size_t m_windowBegin;
+		mutable std::size_t m_windowEnd;
+		mutable float m_windowTop;
+		mutable float m_windowBottom;
+		mutable std::size_t m_changedBegin[GeometrySink::LayerCount];
+		mutable std::size_t m_changedEnd[GeometrySink::LayerCount];
+		mutable std::size_t m_unresolvedBegin;
+		mutable std::size_t m_unresolvedEnd;
+		TextStorage m_string;
 		mutable sf::FloatRect m_bounds;
-		mutable std::vector<sfv::Chunk> m_chunks;
-		mutable std::vector<sf::Vertex> m_vertices;
-		mutable std::vector<sf::Vertex> m_outlineVertices;
+		ChunkTree m_chunks;
+		mutable std::vector<GlyphInstance> m_instances;
+		mutable std::vector<GlyphInstance> m_outlineInstances;
+		mutable GlyphShapeTable m_shapes;
+		mutable std::vector<Line> m_lines;
+		mutable std::vector<Segment> m_segments;
+		mutable std::vector<TextLayout::Word> m_words;
+		mutable std::vector<float> m_offsets;
+		std::size_t m_editDepth;
+		std::vector<PendingEdit> m_edits;
+		std::vector<PendingShift> m_shifts;
+		// Number of queued changes whose colors the per character colors already hold
+		std::size_t m_paintedEdits;
+		// Per character attributes, empty until set
+		std::vector<sf::Color> m_glyphFillColors;
+		std::vector<sf::Color> m_glyphOutlineColors;
+		std::vector<sf::Vector2f> m_glyphOffsets;
+		std::size_t m_scrollback;
+		// Lines at the last layout plus the newlines appended since, so appends check the scrollback without laying out
+		mutable std::size_t m_lineCount;
+#ifdef SFV_STATISTICS
+		mutable TextStatistics m_statistics;
+		// Capacities seen last, to tell when an array moved
+		mutable std::size_t m_instanceCapacity;
+		mutable std::size_t m_chunkCapacity;
+#endif
 	public:
+		// Keeps an edit open while it lives, see beginEdit
+		class EditScope {
+		private:
+			VividText& m_text;
+		public:
+			explicit EditScope(VividText& text);
+			~EditScope();
+
+			EditScope(const EditScope&) = delete;
+			EditScope& operator=(const EditScope&) = delete;
+		};
+
 		VividText(const sf::String& text, const sf::Font& font);
 		VividText();
 		~VividText();
@@ -69,8 +167,100 @@ namespace sfv {
 
 
 
+		// Every overload writes over the characters already held, and only allocates when the text is
+		// longer than any it held before
 		void setString(const sf::String& text);
 
+		void setString(sf::String&& text);
+
+		void setString(std::u32string_view text);
+
+		// Narrow strings are read as UTF-8, invalid sequences become U+FFFD
+		void setString(std::string_view text);
+
+		void setString(const std::string& text);
+
+		void setString(const char* text);
+
+		// Replace the string and its runs with tagged text, see MarkupParser for the tags.
+		// Text outside of any tag gets the attributes of base, and the font of the text when base has none.
+		void setMarkup(const sf::String& markup, const FontRegistry& fonts, const Chunk& base = Chunk());
+
+		// Wrap lines after the last word that fits in width, zero keeps every paragraph on one line.
+		// The words of the paragraphs are cached, so changing the width only lays out again the paragraphs
+		// that break somewhere else.
+		void setMaxWidth(float width);
+
+		float getMaxWidth() const;
+
+		// Only make and draw the quads of the lines around viewport, in local coordinates, keeping a viewport
+		// of lines above and below it so scrolling lays a few lines out at a time. Every other line is only
+		// measured, so bounds and character positions still cover the whole text. An empty viewport culls nothing.
+		void setViewport(const sf::FloatRect& viewport);
+
+		const sf::FloatRect& getViewport() const;
+
+		// Take the viewport from the view of the target at every draw, nothing is laid out before the first one
+		void setFollowView(bool follow);
+
+		bool getFollowView() const;
+
+		// Copy the glyphs into a shared atlas so every font and size is drawn from the same texture.
+		// Pass nullptr to draw from the font textures again, and set it again after clearing the atlas.
+		void setGlyphAtlas(GlyphAtlas* atlas);
+
+		GlyphAtlas* getGlyphAtlas() const;
+
+		// Lay large edits out a few paragraphs per worker of the pool, with the same result as on one thread.
+		// The pool must not be running anything else when the text is updated. Pass nullptr to stay on one thread.
+		void setWorkerPool(WorkerPool* pool);
+
+		WorkerPool* getWorkerPool() const;
+
+		// Hand the vertices to a sink before drawing, only the ranges that changed are passed on.
+		// Pass nullptr to draw from the vertices of the text again.
+		void setGeometrySink(GeometrySink* sink);
+
+		GeometrySink* getGeometrySink() const;
+
+		// Share the geometry of texts with the same characters, runs and maximum width through a cache,
+		// e.g. LayoutCache::getDefault(), so each of them only keeps a reference to it. Texts culled to a viewport,
+		// drawn from a glyph atlas or through a sink, or with attributes of their own per character,
+		// lay themselves out as before. Edits lay a sharing text out from scratch, or find it in the cache again.
+		// Pass nullptr to stop sharing.
+		void setLayoutCache(LayoutCache* cache);
+
+		LayoutCache* getLayoutCache() const;
+
+		// Share the styles of the runs with the other texts using the same table, e.g. StyleTable::getDefault(),
+		// instead of keeping them in a table of the text's own. Texts sharing a table must be edited from one
+		// thread at a time, and the table must outlive them.
+		void setStyleTable(StyleTable& styles);
+
+		StyleTable& getStyleTable() const;
+
+		// Keep the characters as Latin-1, or UTF-8 once one does not fit in a byte, instead of UTF-32.
+		// Lines are laid out decoding the characters one after the other, and getString builds the
+		// UTF-32 string the first time it is asked for after a change, which the next change frees again.
+		void setCompactString(bool compact);
+
+		bool isCompactString() const;
+
+		// Bytes the characters of the text take, without the string getString builds from a compact one
+		std::size_t getStringByteSize() const;
+
+		// Bumped every time the geometry changes, after it was brought up to date
+		std::size_t getGeometryRevision() const;
+
+		// Four vertices per quad of a layer, to be drawn as triangles with getQuadIndices.
+		// Only the lines around the viewport have quads while culling.
+		void exportQuads(GeometrySink::Layer layer, std::vector<sf::Vertex>& vertices) const;
+
+		// Bring the geometry of many texts up to date at once, laying them out on the workers of the pool.
+		// Glyphs are loaded from the fonts beforehand on the calling thread and the workers only read the glyph
+		// caches, while font textures and glyph atlases are only touched once they are done, so SFML is never
+		// used off the calling thread. A text whose layout missed a metric is laid out again on the calling thread.
+		static void prepare(const std::vector<const VividText*>& texts, WorkerPool& pool);
 
 
 		const sf::String& getString() const;
@@ -79,7 +269,8 @@ namespace sfv {
 
 		sf::FloatRect getGlobalBounds() const;
 
-		const Chunk& getChunk(std::size_t index) const;
+		// Attributes and length of a run, read back from its style
+		Chunk getChunk(std::size_t index) const;
 
 		const std::size_t getChunkIndex(std::size_t subIndex) const;
 
@@ -87,24 +278,172 @@ namespace sfv {
 
 		sf::Vector2f findGlobalCharacterPos(std::size_t subIndex) const;
 
+		// Character under a point, for placing a caret where the mouse is. Both this and the character
+		// positions are looked up in the pen positions kept by the layout, in logarithmic time.
+		TextLayout::Hit findLocalCharacter(sf::Vector2f point) const;
+
+		TextLayout::Hit findGlobalCharacter(sf::Vector2f point) const;
+
 		void insert(const sf::String& text, std::size_t index, bool left);
 
 		void insert(const sf::String& text, std::size_t index);
 
 		void erase(std::size_t start, std::size_t length = 1);
 
+		// Add text at the end with the attributes of chunk, and the font of the text when chunk has none.
+		// Only the paragraph the text lands in is laid out again, so appending to a log that ends with a newline
+		// costs about as much as laying out the new characters, however long the log already is.
+		void append(const sf::String& text, const Chunk& chunk = Chunk());
+
+		// Same as append for tagged text, see setMarkup
+		void appendMarkup(const sf::String& markup, const FontRegistry& fonts, const Chunk& base = Chunk());
+
+		// Keep at most lines lines once an append goes past it, dropping whole paragraphs from the top.
+		// Lines are dropped an eighth of the limit at a time, so moving the ones left is shared by many appends.
+		// Appends count the newlines they add and only lay the text out once those pass the limit, lines wrapped
+		// since the text was last drawn are counted by the next append.
+		// Zero keeps every line.
+		void setScrollback(std::size_t lines);
+
+		std::size_t getScrollback() const;
+
+		// Give count characters from start their own fill colors, read from colors, so rainbows and gradients
+		// cost one write per character instead of a run per character. From then on every character keeps its
+		// own fill color: the range setters write it too, and inserted text takes the color of its run.
+		void setGlyphFillColors(const sf::Color* colors, std::size_t start, std::size_t count);
+
+		// Same as setGlyphFillColors for the outline colors
+		void setGlyphOutlineColors(const sf::Color* colors, std::size_t start, std::size_t count);
+
+		// Move the quads of count characters from start, the characters after them stay where they are
+		void setGlyphOffsets(const sf::Vector2f* offsets, std::size_t start, std::size_t count);
+
+		// Go back to the attributes of the runs for every character
+		void clearGlyphAttributes();
+
+		// Queue the attribute changes of the setters until the matching commitEdit, which folds them into
+		// the runs in a single sweep and marks one dirty range. Each setter only appends to the queue.
+		// Inserts and erases still happen right away, the queued ranges move along with them.
+		// Until the commit the runs, and the geometry, keep the attributes from before the edit.
+		// Per character colors set during an edit are written right away, over the colors queued before them.
+		// Edits nest, only the outermost commit applies the changes.
+		void beginEdit();
+
+		void commitEdit();
+
+		bool isEditing() const;
+
+		// Counters of this text since the last reset, all zero unless the library is built with SFV_STATISTICS
+		TextStatistics getStatistics() const;
+
+		void resetStatistics();
+
+		// Counters of every text together
+		static TextStatistics getTotalStatistics();
+
+		static void resetTotalStatistics();
+
+		// Attach an external profiler to the zones texts go through, null functions detach it.
+		// Set it while no text is being laid out. Only called with SFV_STATISTICS.
+		static void setProfilerHooks(const ProfilerHooks& hooks);
+
 	private:
 		virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 
+		void drawSegments(sf::RenderTarget& target, sf::RenderStates states, GeometrySink::Layer layer, std::size_t Segment::* count) const;
+
+		void drawVertices(sf::RenderTarget& target, const sf::RenderStates& states, GeometrySink::Layer layer, std::size_t first, std::size_t count) const;
+
+		void markChanged(GeometrySink::Layer layer, std::size_t begin, std::size_t end) const;
+
+		void flushChanges() const;
+
+		const std::vector<sf::Vertex>& expand(GeometrySink::Layer layer, std::size_t first, std::size_t count) const;
+
 		void ensureGeometryUpdate() const;
 
-		void updateChunks(std::size_t start);
+		bool canShareGeometry() const;
+
+		// Take the geometry from the layout cache, giving back the arrays of the text
+		void shareGeometry() const;
+
+		// Geometry drawn and looked up, from the layout cache while the text shares it
+		const std::vector<Line>& getLines() const;
+
+		const std::vector<float>& getOffsets() const;
+
+		const std::vector<Segment>& getSegments() const;
+
+		const std::vector<GlyphInstance>& getInstances(GeometrySink::Layer layer) const;
+
+		const GlyphShapeTable& getShapes() const;
+
+		// Load every metric the next layout reads into the glyph caches
+		void warmGlyphs() const;
+
+		// Lay the edited lines out again, reading fonts through their caches only.
+		// Given a miss flag the layout only finds metrics in the caches, see TextLayout.
+		void layoutGeometry(WorkerPool* pool, std::atomic<bool>* missed = nullptr) const;
+
+		// Break the paragraphs at the new maximum width, from the words of the previous layout
+		void rewrapGeometry(std::atomic<bool>* missed) const;
+
+		// First line of the paragraph holding the character at index, among the lines laid out before the edits
+		std::size_t findParagraphLine(std::size_t index) const;
+
+		// Lay out the lines around the viewport, or every line without one, and drop the quads of the others
+		void cullGeometry() const;
+
+		// Drop the quads of the lines from line on, cullGeometry lays them out again
+		void truncateWindow(std::size_t line) const;
+
+		bool isCulling() const;
+
+		// Point the lines laid out since the last call at their textures, fonts bound to other metrics have none
+		void resolveGeometry() const;
+
+		void moveToAtlas(Segment& segment, GlyphInstance* fill, GlyphInstance* stroke) const;
+
+		void invalidate(std::size_t start, std::size_t removed, std::size_t inserted);
+
+		// Apply the queued attribute changes, past the inserts and erases made after each of them
+		void resolveEdits();
+
+		// Where the changes queued from firstEdit on lie in the current text, in the order they were made
+		std::vector<Fragment> shiftEdits(std::size_t firstEdit) const;
+
+		// Copy the colors of the changes queued from firstEdit on into a per character channel that is set
+		void paintEdits(std::vector<sf::Color>& channel, std::optional<sf::Color> ChunkBuilder::* color, const std::vector<Fragment>& fragments, std::size_t firstEdit) const;
+
+		bool canRecolor(std::size_t subIndex, std::size_t length, const ChunkBuilder& chunk) const;
+
+		// Patch the colors of the quads of the characters in range from their current colors
+		void recolor(std::size_t subIndex, std::size_t length, bool fillChanged, bool outlineChanged);
+
+		void setGlyphColors(std::vector<sf::Color>& channel, sf::Color Chunk::* color, const sf::Color* colors, std::size_t start, std::size_t count);
+
+		TextLayout::GlyphAttributes getGlyphAttributes() const;
+
+		std::size_t splitChunk(std::size_t subIndex);
+
+		void mergeChunks(std::size_t first, std::size_t last);
 
 		void insertChunk(std::size_t subIndex, const Chunk& chunk);
 
 		void replaceChunk(std::size_t subIndex, const ChunkBuilder& chunk);
 
 		void eraseChunk(std::size_t subIndex, std::size_t length);
+
+		// Count the arrays that grew into a new block since the last call
+		void countReallocations() const;
+
+		void appendRuns(const sf::String& text, const Chunk* runs, std::size_t count);
+
+		// Give the string just assigned a single run and lay it out from scratch
+		void resetString();
+
+		// Drop the paragraphs above the scrollback once there are more than slack lines past it
+		void trimScrollback(std::size_t slack);
 	};
 }
 
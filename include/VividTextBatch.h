@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef SFV_VIVID_TEXT_BATCH_H
+#define SFV_VIVID_TEXT_BATCH_H
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Transform.hpp>
+#include <unordered_map>
+#include <vector>
+#include "VividText.h"
+
+namespace sfv {
+
+	// Draws many VividText objects from shared vertex streams, one per texture and layer.
+	// Every member is stored already transformed and only rewritten when it moved or
+	// its geometry changed, so a set of labels costs a handful of draw calls.
+	// Outlines of every member are drawn below every fill, so overlapping members
+	// may stack differently than when drawn one by one.
+	// Members are not owned, remove them before they are destroyed.
+	class VividTextBatch : public sf::Drawable {
+	private:
+		// Slot of a member inside a stream
+		struct Range {
+			std::size_t stream;
+			std::size_t begin;
+			std::size_t count;
+		};
+
+		struct Member {
+			const VividText* text;
+			sf::Transform transform;
+			std::size_t revision;
+			std::vector<Range> ranges;
+		};
+
+		struct Stream {
+			const sf::Texture* texture;
+			GeometrySink::Layer layer;
+			std::vector<sf::Vertex> vertices;
+			std::size_t unused;
+		};
+
+		mutable std::vector<Member> m_members;
+		std::unordered_map<const VividText*, std::size_t> m_indices;
+		mutable std::vector<Stream> m_streams;
+		mutable std::vector<sf::Vertex> m_scratch;
+		mutable std::vector<Range> m_counts;
+	public:
+		VividTextBatch();
+
+		void add(const VividText& text);
+
+		void remove(const VividText& text);
+
+		bool contains(const VividText& text) const;
+
+		std::size_t size() const;
+
+		void clear();
+
+		// Rewrite the members that moved or changed, draw does it as well
+		void update() const;
+
+		// Number of draw calls the next draw makes
+		std::size_t getBatchCount() const;
+
+	private:
+		virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+		std::size_t findStream(const sf::Texture* texture, GeometrySink::Layer layer) const;
+
+		void release(Member& member) const;
+
+		void write(Member& member) const;
+
+		void compact(std::size_t stream) const;
+	};
+}
+#endif
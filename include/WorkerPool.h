@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef SFV_WORKER_POOL_H
+#define SFV_WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sfv {
+
+	// Fixed set of threads running batches of independent tasks.
+	// Every worker starts on its own queue and steals from the others once it runs dry,
+	// so a few large tasks do not leave the other threads idle.
+	class WorkerPool {
+	private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<std::size_t> tasks;
+		};
+
+		typedef std::function<void(std::size_t)> Task;
+
+		std::vector<std::thread> m_threads;
+		std::vector<std::unique_ptr<Queue>> m_queues;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		const Task* m_task;
+		std::size_t m_round;
+		std::size_t m_finished;
+		bool m_stopping;
+	public:
+		// The calling thread counts as one of the workers, a pool of one runs everything on it
+		explicit WorkerPool(std::size_t workerCount = std::thread::hardware_concurrency());
+
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		std::size_t getWorkerCount() const;
+
+		// Call task once for every index below count and return when all calls are done.
+		// Workers take their indices in increasing order, so pass the largest tasks first.
+		// Tasks must not throw nor run the pool again.
+		void run(std::size_t count, const Task& task);
+
+	private:
+		void loop(std::size_t worker);
+
+		void work(std::size_t worker, const Task& task);
+
+		bool take(std::size_t worker, std::size_t& task);
+	};
+}
+#endif
@@ -1,28 +1,23 @@
 #include "Chunk.h"
 #include <SFML/Graphics/Text.hpp>
 sfv::Chunk::Chunk()
-	: Chunk(static_cast<int>(-1), 0)
+	: Chunk(0)
 {
 }
 
-sfv::Chunk::Chunk(std::size_t index_, std::size_t length_, const sf::Font* font_)
-	: index(index_),
-	length(length_),
+sfv::Chunk::Chunk(std::size_t length_, const sf::Font* font_)
+	: length(length_),
 	fillColor(sf::Color::White),
 	outlineColor(sf::Color::Black),
 	style(sf::Text::Style::Regular),
 	characterSize(18),
-	outlineThickness(0.f),
 	font(font_),
-	verticeLength(0),
-	outlineLength(0)
+	outlineThickness(0.f)
 {
 }
 
 sfv::Chunk::Chunk(const Chunk& chunk) noexcept
-	: index(chunk.index),
-	length(chunk.length),
-	verticeLength(chunk.verticeLength),
+	: length(chunk.length),
 	fillColor(chunk.fillColor),
 	outlineColor(chunk.outlineColor),
 	lineColor(chunk.lineColor),
@@ -35,9 +30,7 @@ sfv::Chunk::Chunk(const Chunk& chunk) noexcept
 }
 
 sfv::Chunk::Chunk(Chunk&& chunk) noexcept
-	: index(std::move(chunk.index)),
-	length(std::move(chunk.length)),
-	verticeLength(std::move(chunk.verticeLength)),
+	: length(std::move(chunk.length)),
 	fillColor(std::move(chunk.fillColor)),
 	outlineColor(std::move(chunk.outlineColor)),
 	lineColor(std::move(chunk.lineColor)),
@@ -51,9 +44,7 @@ sfv::Chunk::Chunk(Chunk&& chunk) noexcept
 
 sfv::Chunk& sfv::Chunk::operator=(const Chunk& chunk) noexcept
 {
-	index = chunk.index;
 	length = chunk.length;
-	verticeLength = chunk.verticeLength;
 	fillColor = chunk.fillColor;
 	outlineColor = chunk.outlineColor;
 	lineColor = chunk.lineColor;
@@ -67,9 +58,7 @@ sfv::Chunk& sfv::Chunk::operator=(const Chunk& chunk) noexcept
 
 sfv::Chunk& sfv::Chunk::operator=(Chunk&& chunk) noexcept
 {
-	index = std::move(chunk.index);
 	length = std::move(chunk.length);
-	verticeLength = std::move(chunk.verticeLength);
 	fillColor = std::move(chunk.fillColor);
 	outlineColor = std::move(chunk.outlineColor);
 	lineColor = std::move(chunk.lineColor);
@@ -88,7 +77,7 @@ float sfv::Chunk::getHeight() const
 
 bool sfv::Chunk::operator==(const Chunk& chunk) const
 {
-	return fillColor == chunk.fillColor && outlineColor == chunk.outlineColor && outlineThickness == chunk.outlineThickness
+	return fillColor == chunk.fillColor && outlineColor == chunk.outlineColor && lineColor == chunk.lineColor && outlineThickness == chunk.outlineThickness
 		   &&  style == chunk.style     && characterSize == chunk.characterSize && font == chunk.font;
 }
 
@@ -132,3 +121,16 @@ sfv::ChunkBuilder& sfv::ChunkBuilder::charSize(sf::Uint32 size)
 	characterSize.emplace(size);
 	return *this;
 }
+
+void sfv::ChunkBuilder::apply(Chunk& chunk) const
+{
+	if (font) {
+		chunk.font = font;
+	}
+	chunk.outlineThickness = outlineThickness.value_or(chunk.outlineThickness);
+	chunk.characterSize = characterSize.value_or(chunk.characterSize);
+	chunk.outlineColor = outlineColor.value_or(chunk.outlineColor);
+	chunk.fillColor = fillColor.value_or(chunk.fillColor);
+	chunk.style = style.value_or(chunk.style);
+	chunk.lineColor = lineColor.value_or(chunk.lineColor);
+}
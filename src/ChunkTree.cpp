@@ -0,0 +1,575 @@
+#include "ChunkTree.h"
+#include <utility>
+
+namespace
+{
+	// Nodes left to release, kept between calls so clearing and erasing do not allocate
+	std::vector<std::uint32_t>& pendingNodes()
+	{
+		thread_local std::vector<std::uint32_t> nodes;
+		return nodes;
+	}
+}
+
+sfv::ChunkTree::const_iterator::const_iterator(const ChunkTree* tree, Node node)
+	: m_tree(tree),
+	m_node(node)
+{
+}
+
+const sfv::ChunkTree::Run& sfv::ChunkTree::const_iterator::operator*() const
+{
+	return m_tree->m_nodes[m_node].run;
+}
+
+const sfv::ChunkTree::Run* sfv::ChunkTree::const_iterator::operator->() const
+{
+	return &m_tree->m_nodes[m_node].run;
+}
+
+sfv::ChunkTree::const_iterator& sfv::ChunkTree::const_iterator::operator++()
+{
+	const auto& nodes = m_tree->m_nodes;
+	if (nodes[m_node].right != NIL) {
+		m_node = nodes[m_node].right;
+		while (nodes[m_node].left != NIL) {
+			m_node = nodes[m_node].left;
+		}
+		return *this;
+	}
+	Node parent = nodes[m_node].parent;
+	while (parent != NIL && nodes[parent].right == m_node) {
+		m_node = parent;
+		parent = nodes[m_node].parent;
+	}
+	m_node = parent;
+	return *this;
+}
+
+bool sfv::ChunkTree::const_iterator::operator==(const const_iterator& other) const
+{
+	return m_node == other.m_node;
+}
+
+bool sfv::ChunkTree::const_iterator::operator!=(const const_iterator& other) const
+{
+	return m_node != other.m_node;
+}
+
+sfv::ChunkTree::ChunkTree()
+	: m_root(NIL),
+	m_seed(0x9E3779B9),
+	m_styles(nullptr)
+{
+}
+
+sfv::ChunkTree::ChunkTree(StyleTable& styles)
+	: m_root(NIL),
+	m_seed(0x9E3779B9),
+	m_styles(&styles)
+{
+}
+
+sfv::ChunkTree::ChunkTree(const ChunkTree& tree)
+	: m_nodes(tree.m_nodes),
+	m_free(tree.m_free),
+	m_root(tree.m_root),
+	m_seed(tree.m_seed),
+	m_styles(tree.m_ownStyles ? nullptr : tree.m_styles)
+{
+	// A copy of a tree with its own table gets its own table too
+	for (const_iterator it = begin(); it != end(); ++it) {
+		Run& run = m_nodes[it.m_node].run;
+		if (tree.m_ownStyles) {
+			run.style = getStyleTable().acquire(tree.getStyle(run));
+		}
+		else {
+			m_styles->retain(run.style);
+		}
+	}
+}
+
+sfv::ChunkTree::ChunkTree(ChunkTree&& tree) noexcept
+	: m_nodes(std::move(tree.m_nodes)),
+	m_free(std::move(tree.m_free)),
+	m_root(tree.m_root),
+	m_seed(tree.m_seed),
+	m_styles(tree.m_styles),
+	m_ownStyles(std::move(tree.m_ownStyles))
+{
+	tree.m_nodes.clear();
+	tree.m_free.clear();
+	tree.m_root = NIL;
+	if (m_ownStyles) {
+		tree.m_styles = nullptr;
+	}
+}
+
+sfv::ChunkTree& sfv::ChunkTree::operator=(const ChunkTree& tree)
+{
+	if (this != &tree) {
+		ChunkTree copy(tree);
+		*this = std::move(copy);
+	}
+	return *this;
+}
+
+sfv::ChunkTree& sfv::ChunkTree::operator=(ChunkTree&& tree) noexcept
+{
+	if (this != &tree) {
+		clear();
+		m_nodes.swap(tree.m_nodes);
+		m_free.swap(tree.m_free);
+		std::swap(m_root, tree.m_root);
+		m_seed = tree.m_seed;
+		m_styles = tree.m_styles;
+		m_ownStyles = std::move(tree.m_ownStyles);
+		if (m_ownStyles) {
+			tree.m_styles = nullptr;
+		}
+	}
+	return *this;
+}
+
+sfv::ChunkTree::~ChunkTree()
+{
+	clear();
+}
+
+sfv::StyleTable& sfv::ChunkTree::getStyleTable() const
+{
+	if (!m_styles) {
+		m_ownStyles.reset(new StyleTable());
+		m_styles = m_ownStyles.get();
+	}
+	return *m_styles;
+}
+
+void sfv::ChunkTree::setStyleTable(StyleTable& styles)
+{
+	if (&styles == m_styles) {
+		return;
+	}
+	for (const_iterator it = begin(); it != end(); ++it) {
+		Run& run = m_nodes[it.m_node].run;
+		const StyleTable::Id style = styles.acquire((*m_styles)[run.style]);
+		m_styles->release(run.style);
+		run.style = style;
+	}
+	m_styles = &styles;
+	m_ownStyles.reset();
+}
+
+std::size_t sfv::ChunkTree::size() const
+{
+	return count(m_root);
+}
+
+std::size_t sfv::ChunkTree::length() const
+{
+	return sum(m_root);
+}
+
+bool sfv::ChunkTree::empty() const
+{
+	return m_root == NIL;
+}
+
+std::size_t sfv::ChunkTree::capacity() const
+{
+	return m_nodes.capacity();
+}
+
+const sfv::ChunkTree::Run& sfv::ChunkTree::operator[](std::size_t index) const
+{
+	return m_nodes[locate(index)].run;
+}
+
+const sfv::ChunkTree::Run& sfv::ChunkTree::front() const
+{
+	return operator[](0);
+}
+
+const sfv::ChunkTree::Run& sfv::ChunkTree::back() const
+{
+	return operator[](size() - 1);
+}
+
+const sfv::Chunk& sfv::ChunkTree::getStyle(const Run& run) const
+{
+	return (*m_styles)[run.style];
+}
+
+sfv::Chunk sfv::ChunkTree::getChunk(std::size_t index) const
+{
+	const Run& run = operator[](index);
+	Chunk chunk = getStyle(run);
+	chunk.length = run.length;
+	return chunk;
+}
+
+sfv::ChunkTree::Location sfv::ChunkTree::find(std::size_t subIndex) const
+{
+	Location location{ 0, 0 };
+	if (subIndex >= length()) {
+		location.index = size();
+		location.start = length();
+		return location;
+	}
+	Node node = m_root;
+	while (node != NIL) {
+		const NodeData& data = m_nodes[node];
+		const std::size_t left = sum(data.left);
+		if (subIndex < left) {
+			node = data.left;
+		}
+		else if (subIndex < left + data.run.length) {
+			location.index += count(data.left);
+			location.start += left;
+			return location;
+		}
+		else {
+			subIndex -= left + data.run.length;
+			location.index += count(data.left) + 1;
+			location.start += left + data.run.length;
+			node = data.right;
+		}
+	}
+	return location;
+}
+
+std::size_t sfv::ChunkTree::start(std::size_t index) const
+{
+	std::size_t offset = 0;
+	Node node = m_root;
+	while (node != NIL) {
+		const NodeData& data = m_nodes[node];
+		const std::size_t left = count(data.left);
+		if (index < left) {
+			node = data.left;
+		}
+		else if (index == left) {
+			return offset + sum(data.left);
+		}
+		else {
+			index -= left + 1;
+			offset += sum(data.left) + data.run.length;
+			node = data.right;
+		}
+	}
+	return offset;
+}
+
+sfv::ChunkTree::const_iterator sfv::ChunkTree::begin() const
+{
+	return at(0);
+}
+
+sfv::ChunkTree::const_iterator sfv::ChunkTree::end() const
+{
+	return const_iterator(this, NIL);
+}
+
+sfv::ChunkTree::const_iterator sfv::ChunkTree::at(std::size_t index) const
+{
+	return const_iterator(this, index < size() ? locate(index) : NIL);
+}
+
+void sfv::ChunkTree::clear()
+{
+	releaseAll(m_root);
+	m_nodes.clear();
+	m_free.clear();
+	m_root = NIL;
+}
+
+void sfv::ChunkTree::assign(const std::vector<Chunk>& chunks)
+{
+	clear();
+	m_nodes.reserve(chunks.size());
+	m_root = build(chunks.data(), chunks.size());
+}
+
+void sfv::ChunkTree::replace(std::size_t index, std::size_t count, const std::vector<Chunk>& chunks)
+{
+	Node left, middle, right;
+	split(m_root, index, left, middle);
+	split(middle, count, middle, right);
+	const Node built = build(chunks.data(), chunks.size());
+	releaseAll(middle);
+	m_root = merge(merge(left, built), right);
+	if (m_root != NIL) {
+		m_nodes[m_root].parent = NIL;
+	}
+}
+
+void sfv::ChunkTree::replace(std::size_t index, std::size_t count, const std::vector<Run>& runs)
+{
+	Node left, middle, right;
+	split(m_root, index, left, middle);
+	split(middle, count, middle, right);
+	// The new runs may share the styles of the old ones, so they are referenced before those are released
+	const Node built = build(runs.data(), runs.size());
+	releaseAll(middle);
+	m_root = merge(merge(left, built), right);
+	if (m_root != NIL) {
+		m_nodes[m_root].parent = NIL;
+	}
+}
+
+void sfv::ChunkTree::insert(std::size_t index, const Chunk& chunk)
+{
+	Node left, right;
+	split(m_root, index, left, right);
+	m_root = merge(merge(left, allocate(Run{ static_cast<std::uint32_t>(chunk.length), getStyleTable().acquire(chunk) })), right);
+	m_nodes[m_root].parent = NIL;
+}
+
+void sfv::ChunkTree::insert(std::size_t index, const Run& run)
+{
+	getStyleTable().retain(run.style);
+	Node left, right;
+	split(m_root, index, left, right);
+	m_root = merge(merge(left, allocate(run)), right);
+	m_nodes[m_root].parent = NIL;
+}
+
+void sfv::ChunkTree::erase(std::size_t index, std::size_t count)
+{
+	Node left, middle, right;
+	split(m_root, index, left, middle);
+	split(middle, count, middle, right);
+	m_root = merge(left, right);
+	if (m_root != NIL) {
+		m_nodes[m_root].parent = NIL;
+	}
+	releaseAll(middle);
+}
+
+void sfv::ChunkTree::assign(std::size_t index, const Chunk& chunk)
+{
+	const Node node = locate(index);
+	const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(chunk.length) - static_cast<std::ptrdiff_t>(m_nodes[node].run.length);
+	const StyleTable::Id style = getStyleTable().acquire(chunk);
+	m_styles->release(m_nodes[node].run.style);
+	m_nodes[node].run = Run{ static_cast<std::uint32_t>(chunk.length), style };
+	adjust(index, delta);
+}
+
+void sfv::ChunkTree::restyle(std::size_t index, const ChunkBuilder& data)
+{
+	Run& run = m_nodes[locate(index)].run;
+	const StyleTable::Id style = m_styles->derive(run.style, data);
+	m_styles->release(run.style);
+	run.style = style;
+}
+
+void sfv::ChunkTree::resize(std::size_t index, std::size_t length)
+{
+	const Node node = locate(index);
+	const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(length) - static_cast<std::ptrdiff_t>(m_nodes[node].run.length);
+	m_nodes[node].run.length = static_cast<std::uint32_t>(length);
+	adjust(index, delta);
+}
+
+sfv::ChunkTree::Node sfv::ChunkTree::allocate(const Run& run)
+{
+	// xorshift32, only used to keep the treap balanced
+	m_seed ^= m_seed << 13;
+	m_seed ^= m_seed >> 17;
+	m_seed ^= m_seed << 5;
+
+	Node node;
+	if (!m_free.empty()) {
+		node = m_free.back();
+		m_free.pop_back();
+	}
+	else {
+		node = static_cast<Node>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+	NodeData& data = m_nodes[node];
+	data.run = run;
+	data.left = NIL;
+	data.right = NIL;
+	data.parent = NIL;
+	data.priority = m_seed;
+	data.count = 1;
+	data.sum = run.length;
+	return node;
+}
+
+void sfv::ChunkTree::release(Node node)
+{
+	m_styles->release(m_nodes[node].run.style);
+	m_free.push_back(node);
+}
+
+void sfv::ChunkTree::releaseAll(Node root)
+{
+	// Hand the detached nodes back to the free list
+	std::vector<Node>& pending = pendingNodes();
+	if (root != NIL) {
+		pending.push_back(root);
+	}
+	while (!pending.empty()) {
+		const Node node = pending.back();
+		pending.pop_back();
+		if (m_nodes[node].left != NIL) {
+			pending.push_back(m_nodes[node].left);
+		}
+		if (m_nodes[node].right != NIL) {
+			pending.push_back(m_nodes[node].right);
+		}
+		release(node);
+	}
+}
+
+template <typename T, typename Acquire>
+sfv::ChunkTree::Node sfv::ChunkTree::build(const T* items, std::size_t count, Acquire acquire)
+{
+	// Runs arrive in order, so the treap is built along its right spine without any split
+	std::vector<Node> spine;
+	for (std::size_t index = 0; index != count; ++index) {
+		const Node node = allocate(acquire(items[index]));
+		Node left = NIL;
+		while (!spine.empty() && m_nodes[spine.back()].priority < m_nodes[node].priority) {
+			left = spine.back();
+			spine.pop_back();
+			pull(left);
+		}
+		m_nodes[node].left = left;
+		if (!spine.empty()) {
+			m_nodes[spine.back()].right = node;
+		}
+		spine.push_back(node);
+	}
+	const Node root = spine.empty() ? NIL : spine.front();
+	while (!spine.empty()) {
+		pull(spine.back());
+		spine.pop_back();
+	}
+	return root;
+}
+
+sfv::ChunkTree::Node sfv::ChunkTree::build(const Chunk* chunks, std::size_t count)
+{
+	return build(chunks, count, [this](const Chunk& chunk) {
+		return Run{ static_cast<std::uint32_t>(chunk.length), getStyleTable().acquire(chunk) };
+	});
+}
+
+sfv::ChunkTree::Node sfv::ChunkTree::build(const Run* runs, std::size_t count)
+{
+	return build(runs, count, [this](const Run& run) {
+		getStyleTable().retain(run.style);
+		return run;
+	});
+}
+
+std::size_t sfv::ChunkTree::count(Node node) const
+{
+	return node != NIL ? m_nodes[node].count : 0;
+}
+
+std::size_t sfv::ChunkTree::sum(Node node) const
+{
+	return node != NIL ? m_nodes[node].sum : 0;
+}
+
+void sfv::ChunkTree::pull(Node node)
+{
+	NodeData& data = m_nodes[node];
+	data.count = static_cast<std::uint32_t>(1 + count(data.left) + count(data.right));
+	data.sum = static_cast<std::uint32_t>(data.run.length + sum(data.left) + sum(data.right));
+	if (data.left != NIL) {
+		m_nodes[data.left].parent = node;
+	}
+	if (data.right != NIL) {
+		m_nodes[data.right].parent = node;
+	}
+}
+
+void sfv::ChunkTree::split(Node node, std::size_t index, Node& left, Node& right)
+{
+	if (node == NIL) {
+		left = right = NIL;
+		return;
+	}
+	const std::size_t leftCount = count(m_nodes[node].left);
+	if (leftCount < index) {
+		Node rest;
+		split(m_nodes[node].right, index - leftCount - 1, rest, right);
+		m_nodes[node].right = rest;
+		left = node;
+	}
+	else {
+		Node rest;
+		split(m_nodes[node].left, index, left, rest);
+		m_nodes[node].left = rest;
+		right = node;
+	}
+	pull(node);
+	m_nodes[node].parent = NIL;
+}
+
+sfv::ChunkTree::Node sfv::ChunkTree::merge(Node left, Node right)
+{
+	if (left == NIL) {
+		return right;
+	}
+	if (right == NIL) {
+		return left;
+	}
+	if (m_nodes[left].priority > m_nodes[right].priority) {
+		const Node child = merge(m_nodes[left].right, right);
+		m_nodes[left].right = child;
+		pull(left);
+		return left;
+	}
+	const Node child = merge(left, m_nodes[right].left);
+	m_nodes[right].left = child;
+	pull(right);
+	return right;
+}
+
+sfv::ChunkTree::Node sfv::ChunkTree::locate(std::size_t index) const
+{
+	Node node = m_root;
+	while (node != NIL) {
+		const std::size_t left = count(m_nodes[node].left);
+		if (index < left) {
+			node = m_nodes[node].left;
+		}
+		else if (index == left) {
+			return node;
+		}
+		else {
+			index -= left + 1;
+			node = m_nodes[node].right;
+		}
+	}
+	return NIL;
+}
+
+void sfv::ChunkTree::adjust(std::size_t index, std::ptrdiff_t delta)
+{
+	if (delta == 0) {
+		return;
+	}
+	Node node = m_root;
+	while (node != NIL) {
+		m_nodes[node].sum = static_cast<std::uint32_t>(m_nodes[node].sum + delta);
+		const std::size_t left = count(m_nodes[node].left);
+		if (index < left) {
+			node = m_nodes[node].left;
+		}
+		else if (index == left) {
+			return;
+		}
+		else {
+			index -= left + 1;
+			node = m_nodes[node].right;
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#include "FontMetrics.h"
+
+sfv::FontMetrics::~FontMetrics()
+{
+}
+
+sfv::SfmlFontMetrics::SfmlFontMetrics(const sf::Font& font)
+	: m_font(&font)
+{
+}
+
+const sf::Font& sfv::SfmlFontMetrics::getFont() const
+{
+	return *m_font;
+}
+
+sf::Glyph sfv::SfmlFontMetrics::getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness)
+{
+	return m_font->getGlyph(codePoint, characterSize, bold, outlineThickness);
+}
+
+float sfv::SfmlFontMetrics::getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize)
+{
+	return m_font->getKerning(first, second, characterSize);
+}
+
+float sfv::SfmlFontMetrics::getLineSpacing(sf::Uint32 characterSize)
+{
+	return m_font->getLineSpacing(characterSize);
+}
+
+float sfv::SfmlFontMetrics::getUnderlinePosition(sf::Uint32 characterSize)
+{
+	return m_font->getUnderlinePosition(characterSize);
+}
+
+float sfv::SfmlFontMetrics::getUnderlineThickness(sf::Uint32 characterSize)
+{
+	return m_font->getUnderlineThickness(characterSize);
+}
@@ -0,0 +1,54 @@
+#include "FontRegistry.h"
+
+void sfv::FontRegistry::add(const std::string& name, const sf::Font& font)
+{
+	for (auto& entry : m_fonts) {
+		if (entry.first == name) {
+			entry.second = &font;
+			return;
+		}
+	}
+	m_fonts.emplace_back(name, &font);
+}
+
+void sfv::FontRegistry::remove(const std::string& name)
+{
+	for (auto entry = m_fonts.begin(); entry != m_fonts.end(); ++entry) {
+		if (entry->first == name) {
+			m_fonts.erase(entry);
+			return;
+		}
+	}
+}
+
+void sfv::FontRegistry::clear()
+{
+	m_fonts.clear();
+}
+
+const sf::Font* sfv::FontRegistry::find(const std::string& name) const
+{
+	for (const auto& entry : m_fonts) {
+		if (entry.first == name) {
+			return entry.second;
+		}
+	}
+	return nullptr;
+}
+
+const sf::Font* sfv::FontRegistry::find(const sf::Uint32* name, std::size_t length) const
+{
+	for (const auto& entry : m_fonts) {
+		if (entry.first.size() != length) {
+			continue;
+		}
+		std::size_t index = 0;
+		while (index != length && static_cast<unsigned char>(entry.first[index]) == name[index]) {
+			++index;
+		}
+		if (index == length) {
+			return entry.second;
+		}
+	}
+	return nullptr;
+}
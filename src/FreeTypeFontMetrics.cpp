@@ -0,0 +1,189 @@
+#include "FreeTypeFontMetrics.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+#include FT_OUTLINE_H
+#include FT_BITMAP_H
+#include FT_STROKER_H
+#include <fstream>
+#include <iterator>
+
+sfv::FreeTypeFontMetrics::FreeTypeFontMetrics()
+	: m_library(nullptr),
+	m_face(nullptr),
+	m_stroker(nullptr),
+	m_characterSize(0)
+{
+}
+
+sfv::FreeTypeFontMetrics::~FreeTypeFontMetrics()
+{
+	cleanup();
+}
+
+bool sfv::FreeTypeFontMetrics::loadFromFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		cleanup();
+		return false;
+	}
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	cleanup();
+	m_data.swap(data);
+	return load();
+}
+
+bool sfv::FreeTypeFontMetrics::loadFromMemory(const void* data, std::size_t size)
+{
+	cleanup();
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	m_data.assign(bytes, bytes + size);
+	return load();
+}
+
+sf::Glyph sfv::FreeTypeFontMetrics::getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness)
+{
+	sf::Glyph glyph;
+	if (!setCharacterSize(characterSize)) {
+		return glyph;
+	}
+
+	// Same steps as sf::Font::loadGlyph, minus the texture upload
+	FT_Int32 flags = FT_LOAD_TARGET_NORMAL | FT_LOAD_FORCE_AUTOHINT;
+	if (outlineThickness != 0) {
+		flags |= FT_LOAD_NO_BITMAP;
+	}
+	if (FT_Load_Char(m_face, codePoint, flags) != 0) {
+		return glyph;
+	}
+	FT_Glyph glyphDesc;
+	if (FT_Get_Glyph(m_face->glyph, &glyphDesc) != 0) {
+		return glyph;
+	}
+
+	const FT_Pos weight = 1 << 6;
+	const bool outline = glyphDesc->format == FT_GLYPH_FORMAT_OUTLINE;
+	if (outline) {
+		if (bold) {
+			FT_Outline_Embolden(&reinterpret_cast<FT_OutlineGlyph>(glyphDesc)->outline, weight);
+		}
+		if (outlineThickness != 0) {
+			FT_Stroker_Set(m_stroker, static_cast<FT_Fixed>(outlineThickness * static_cast<float>(1 << 6)), FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0);
+			FT_Glyph_Stroke(&glyphDesc, m_stroker, true);
+		}
+	}
+	FT_Glyph_To_Bitmap(&glyphDesc, FT_RENDER_MODE_NORMAL, 0, 1);
+	FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(glyphDesc);
+	FT_Bitmap& bitmap = bitmapGlyph->bitmap;
+	if (!outline && bold) {
+		FT_Bitmap_Embolden(m_library, &bitmap, weight, weight);
+	}
+
+	glyph.advance = static_cast<float>(m_face->glyph->metrics.horiAdvance) / static_cast<float>(1 << 6);
+	if (bold) {
+		glyph.advance += static_cast<float>(weight) / static_cast<float>(1 << 6);
+	}
+	const int width = static_cast<int>(bitmap.width);
+	const int height = static_cast<int>(bitmap.rows);
+	if (width > 0 && height > 0) {
+		glyph.textureRect = sf::IntRect(0, 0, width, height);
+		glyph.bounds.left = static_cast<float>(bitmapGlyph->left);
+		glyph.bounds.top = static_cast<float>(-bitmapGlyph->top);
+		glyph.bounds.width = static_cast<float>(width);
+		glyph.bounds.height = static_cast<float>(height);
+	}
+	FT_Done_Glyph(glyphDesc);
+	return glyph;
+}
+
+float sfv::FreeTypeFontMetrics::getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize)
+{
+	if (first == 0 || second == 0 || !m_face || !FT_HAS_KERNING(m_face) || !setCharacterSize(characterSize)) {
+		return 0.f;
+	}
+	FT_Vector kerning;
+	FT_Get_Kerning(m_face, FT_Get_Char_Index(m_face, first), FT_Get_Char_Index(m_face, second), FT_KERNING_DEFAULT, &kerning);
+	if (!FT_IS_SCALABLE(m_face)) {
+		return static_cast<float>(kerning.x);
+	}
+	return static_cast<float>(kerning.x >> 6);
+}
+
+float sfv::FreeTypeFontMetrics::getLineSpacing(sf::Uint32 characterSize)
+{
+	if (!setCharacterSize(characterSize)) {
+		return 0.f;
+	}
+	return static_cast<float>(m_face->size->metrics.height) / static_cast<float>(1 << 6);
+}
+
+float sfv::FreeTypeFontMetrics::getUnderlinePosition(sf::Uint32 characterSize)
+{
+	if (!setCharacterSize(characterSize)) {
+		return 0.f;
+	}
+	if (!FT_IS_SCALABLE(m_face)) {
+		return static_cast<float>(characterSize) / 10.f;
+	}
+	return -static_cast<float>(FT_MulFix(m_face->underline_position, m_face->size->metrics.y_scale)) / static_cast<float>(1 << 6);
+}
+
+float sfv::FreeTypeFontMetrics::getUnderlineThickness(sf::Uint32 characterSize)
+{
+	if (!setCharacterSize(characterSize)) {
+		return 0.f;
+	}
+	if (!FT_IS_SCALABLE(m_face)) {
+		return static_cast<float>(characterSize) / 14.f;
+	}
+	return static_cast<float>(FT_MulFix(m_face->underline_thickness, m_face->size->metrics.y_scale)) / static_cast<float>(1 << 6);
+}
+
+bool sfv::FreeTypeFontMetrics::load()
+{
+	if (FT_Init_FreeType(&m_library) != 0) {
+		cleanup();
+		return false;
+	}
+	if (FT_New_Memory_Face(m_library, m_data.data(), static_cast<FT_Long>(m_data.size()), 0, &m_face) != 0 ||
+		FT_Stroker_New(m_library, &m_stroker) != 0 ||
+		FT_Select_Charmap(m_face, FT_ENCODING_UNICODE) != 0) {
+		cleanup();
+		return false;
+	}
+	return true;
+}
+
+bool sfv::FreeTypeFontMetrics::setCharacterSize(sf::Uint32 characterSize)
+{
+	if (!m_face) {
+		return false;
+	}
+	if (m_characterSize == characterSize) {
+		return true;
+	}
+	if (FT_Set_Pixel_Sizes(m_face, 0, characterSize) != 0) {
+		return false;
+	}
+	m_characterSize = characterSize;
+	return true;
+}
+
+void sfv::FreeTypeFontMetrics::cleanup()
+{
+	if (m_stroker) {
+		FT_Stroker_Done(m_stroker);
+	}
+	if (m_face) {
+		FT_Done_Face(m_face);
+	}
+	if (m_library) {
+		FT_Done_FreeType(m_library);
+	}
+	m_stroker = nullptr;
+	m_face = nullptr;
+	m_library = nullptr;
+	m_characterSize = 0;
+	m_data.clear();
+}
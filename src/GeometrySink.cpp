@@ -0,0 +1,78 @@
+#include "GeometrySink.h"
+#include <algorithm>
+
+sfv::GeometrySink::~GeometrySink()
+{
+}
+
+bool sfv::RecordingGeometrySink::update(Layer layer, std::size_t size, std::size_t first, const sf::Vertex* vertices, std::size_t count)
+{
+	std::vector<sf::Vertex>& copy = m_vertices[layer];
+	copy.resize(size);
+	std::copy(vertices, vertices + count, copy.begin() + first);
+	m_uploads.push_back({ layer, first, count, size });
+	return true;
+}
+
+void sfv::RecordingGeometrySink::draw(Layer layer, sf::RenderTarget& target, std::size_t first, std::size_t count, const sf::RenderStates& states)
+{
+	target.draw(m_vertices[layer].data() + first, count, sf::PrimitiveType::Triangles, states);
+}
+
+const std::vector<sf::Vertex>& sfv::RecordingGeometrySink::getVertices(Layer layer) const
+{
+	return m_vertices[layer];
+}
+
+const std::vector<sfv::RecordingGeometrySink::Upload>& sfv::RecordingGeometrySink::getUploads() const
+{
+	return m_uploads;
+}
+
+void sfv::RecordingGeometrySink::clearUploads()
+{
+	m_uploads.clear();
+}
+
+#ifdef SFV_HAS_VERTEX_BUFFER
+sfv::VertexBufferSink::VertexBufferSink(sf::VertexBuffer::Usage usage)
+	: m_uploads(0)
+{
+	for (auto& buffer : m_buffers) {
+		buffer.setPrimitiveType(sf::PrimitiveType::Triangles);
+		buffer.setUsage(usage);
+	}
+}
+
+bool sfv::VertexBufferSink::update(Layer layer, std::size_t size, std::size_t first, const sf::Vertex* vertices, std::size_t count)
+{
+	sf::VertexBuffer& buffer = m_buffers[layer];
+	if (size > buffer.getVertexCount()) {
+		// Creating a buffer drops its content, ask for the whole layer unless this is it
+		buffer.create(size + size / 2);
+		if (first != 0 || count != size) {
+			return false;
+		}
+	}
+	if (count != 0) {
+		buffer.update(vertices, count, static_cast<unsigned int>(first));
+		++m_uploads;
+	}
+	return true;
+}
+
+void sfv::VertexBufferSink::draw(Layer layer, sf::RenderTarget& target, std::size_t first, std::size_t count, const sf::RenderStates& states)
+{
+	target.draw(m_buffers[layer], first, count, states);
+}
+
+const sf::VertexBuffer& sfv::VertexBufferSink::getBuffer(Layer layer) const
+{
+	return m_buffers[layer];
+}
+
+std::size_t sfv::VertexBufferSink::getUploadCount() const
+{
+	return m_uploads;
+}
+#endif
@@ -0,0 +1,173 @@
+#include "GlyphAtlas.h"
+#include <functional>
+
+bool sfv::GlyphAtlas::Key::operator==(const Key& key) const
+{
+	return source == key.source && rect == key.rect;
+}
+
+std::size_t sfv::GlyphAtlas::KeyHash::operator()(const Key& key) const
+{
+	std::size_t hash = std::hash<const void*>()(key.source);
+	const int fields[4] = { key.rect.left, key.rect.top, key.rect.width, key.rect.height };
+	for (int field : fields) {
+		hash ^= std::hash<int>()(field) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+sfv::GlyphAtlas::GlyphAtlas(unsigned int pageSize)
+	: m_pageSize(pageSize)
+{
+}
+
+std::size_t sfv::GlyphAtlas::insert(const void* sourceId, const sf::Image& source, const sf::IntRect* rects, std::size_t count, sf::IntRect* placed)
+{
+	if (m_pages.empty()) {
+		addPage();
+	}
+	// Fill the last page, and move the whole set to a new one if it runs out of room
+	for (int attempt = 0; attempt != 2; ++attempt) {
+		const std::size_t page = m_pages.size() - 1;
+		bool fits = true;
+		for (std::size_t index = 0; index != count && fits; ++index) {
+			const sf::IntRect& rect = rects[index];
+			if (rect.width <= 0 || rect.height <= 0) {
+				placed[index] = rect;
+				continue;
+			}
+			const auto placement = m_placements.find(Key{ sourceId, rect });
+			if (placement != m_placements.end() && placement->second.page == page) {
+				placed[index] = placement->second.rect;
+				continue;
+			}
+			sf::Vector2u position;
+			Page& data = *m_pages[page];
+			if (!pack(data, static_cast<unsigned int>(rect.width), static_cast<unsigned int>(rect.height), position)) {
+				fits = false;
+				continue;
+			}
+			data.image.copy(source, position.x, position.y, rect);
+			data.dirty = true;
+			placed[index] = sf::IntRect(static_cast<int>(position.x), static_cast<int>(position.y), rect.width, rect.height);
+			m_placements[Key{ sourceId, rect }] = Placement{ page, placed[index] };
+		}
+		if (fits) {
+			return page;
+		}
+		if (attempt == 0) {
+			addPage();
+		}
+	}
+	return static_cast<std::size_t>(-1);
+}
+
+std::size_t sfv::GlyphAtlas::insert(const sf::Texture& source, std::size_t generation, const sf::IntRect* rects, std::size_t count, sf::IntRect* placed)
+{
+	bool missing = false;
+	for (std::size_t index = 0; index != count && !missing; ++index) {
+		const sf::IntRect& rect = rects[index];
+		if (rect.width <= 0 || rect.height <= 0) {
+			continue;
+		}
+		const auto placement = m_placements.find(Key{ &source, rect });
+		missing = placement == m_placements.end() || placement->second.page != m_pages.size() - 1;
+	}
+
+	// Reading a texture back is slow, only do it when it may hold pixels we never copied
+	Source& snapshot = m_sources[&source];
+	if (missing && (snapshot.image.getSize() != source.getSize() || snapshot.generation != generation)) {
+		snapshot.image = source.copyToImage();
+		snapshot.generation = generation;
+	}
+	return insert(&source, snapshot.image, rects, count, placed);
+}
+
+std::size_t sfv::GlyphAtlas::getPageCount() const
+{
+	return m_pages.size();
+}
+
+unsigned int sfv::GlyphAtlas::getPageSize() const
+{
+	return m_pageSize;
+}
+
+const sf::Image& sfv::GlyphAtlas::getImage(std::size_t page) const
+{
+	return m_pages[page]->image;
+}
+
+const sf::Texture& sfv::GlyphAtlas::getTexture(std::size_t page) const
+{
+	Page& data = *m_pages[page];
+	if (!data.texture) {
+		data.texture.reset(new sf::Texture());
+	}
+	if (data.dirty) {
+		if (data.texture->getSize().x != m_pageSize) {
+			data.texture->create(m_pageSize, m_pageSize);
+			// Filtered like the pages of sf::Font, so scaled and rotated text looks the same with an atlas
+			data.texture->setSmooth(true);
+		}
+		data.texture->update(data.image);
+		data.dirty = false;
+	}
+	return *data.texture;
+}
+
+void sfv::GlyphAtlas::clear()
+{
+	m_pages.clear();
+	m_placements.clear();
+	m_sources.clear();
+}
+
+sfv::GlyphAtlas::Page& sfv::GlyphAtlas::addPage()
+{
+	m_pages.emplace_back(new Page());
+	Page& page = *m_pages.back();
+	page.image.create(m_pageSize, m_pageSize, sf::Color(255, 255, 255, 0));
+
+	// Reserve a 2x2 white square for texturing underlines and strike throughs
+	for (unsigned int x = 0; x != 2; ++x) {
+		for (unsigned int y = 0; y != 2; ++y) {
+			page.image.setPixel(x, y, sf::Color(255, 255, 255, 255));
+		}
+	}
+	page.nextRow = 3;
+	page.dirty = true;
+	return page;
+}
+
+bool sfv::GlyphAtlas::pack(Page& page, unsigned int width, unsigned int height, sf::Vector2u& position)
+{
+	// Shelf packing with a pixel of padding, following the heuristic of sf::Font
+	const unsigned int paddedWidth = width + 1;
+	const unsigned int paddedHeight = height + 1;
+
+	Row* row = nullptr;
+	float bestRatio = 0.f;
+	for (auto& current : page.rows) {
+		const float ratio = static_cast<float>(paddedHeight) / static_cast<float>(current.height);
+		if (ratio < 0.7f || ratio > 1.f || current.width + paddedWidth > m_pageSize) {
+			continue;
+		}
+		if (ratio >= bestRatio) {
+			row = &current;
+			bestRatio = ratio;
+		}
+	}
+	if (!row) {
+		const unsigned int rowHeight = paddedHeight + paddedHeight / 10;
+		if (paddedWidth > m_pageSize || page.nextRow + rowHeight > m_pageSize) {
+			return false;
+		}
+		page.rows.push_back(Row{ page.nextRow, 0, rowHeight });
+		page.nextRow += rowHeight;
+		row = &page.rows.back();
+	}
+	position = sf::Vector2u(row->width, row->top);
+	row->width += paddedWidth;
+	return true;
+}
@@ -0,0 +1,348 @@
+#include "GlyphCache.h"
+#include <memory>
+#include <unordered_map>
+
+namespace
+{
+	const sf::Uint32 EMPTY_GLYPH = static_cast<sf::Uint32>(-1);
+	const sf::Uint64 EMPTY_KERNING = static_cast<sf::Uint64>(-1);
+
+	typedef std::unordered_map<const sf::Font*, std::unique_ptr<sfv::GlyphCache>> Registry;
+
+	Registry& getRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	// Kerning against the null character
+	const float NO_KERNING = 0.f;
+
+	std::size_t hash(sf::Uint64 key, std::size_t capacity)
+	{
+		key ^= key >> 33;
+		key *= 0xFF51AFD7ED558CCDULL;
+		key ^= key >> 33;
+		return static_cast<std::size_t>(key) & (capacity - 1);
+	}
+
+	// Code points need 21 bits, leaving 22 bits for the character size
+	sf::Uint64 kerningKey(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize)
+	{
+		return (static_cast<sf::Uint64>(first & 0x1FFFFF) << 43) | (static_cast<sf::Uint64>(second & 0x1FFFFF) << 22) | (characterSize & 0x3FFFFF);
+	}
+}
+
+sfv::GlyphCache::GlyphCache(FontMetrics& metrics, std::unique_ptr<FontMetrics> ownedMetrics)
+	: m_metrics(&metrics),
+	m_ownedMetrics(std::move(ownedMetrics)),
+	m_lastFace(0),
+	m_kerningCount(0),
+	m_generation(0),
+	m_statistics()
+{
+}
+
+sfv::GlyphCache& sfv::GlyphCache::get(const sf::Font& font)
+{
+	Registry& registry = getRegistry();
+	const auto found = registry.find(&font);
+	if (found != registry.end()) {
+		return *found->second;
+	}
+	auto& cache = registry[&font];
+	if (!cache) {
+		FontMetrics* metrics = new SfmlFontMetrics(font);
+		cache.reset(new GlyphCache(*metrics, std::unique_ptr<FontMetrics>(metrics)));
+	}
+	return *cache;
+}
+
+sfv::GlyphCache& sfv::GlyphCache::bind(const sf::Font& font, FontMetrics& metrics)
+{
+	auto& cache = getRegistry()[&font];
+	cache.reset(new GlyphCache(metrics, nullptr));
+	return *cache;
+}
+
+void sfv::GlyphCache::release(const sf::Font& font)
+{
+	getRegistry().erase(&font);
+}
+
+sfv::GlyphCache::Statistics sfv::GlyphCache::getTotalStatistics()
+{
+	Statistics total{};
+	for (const auto& cache : getRegistry()) {
+		total.glyphHits += cache.second->m_statistics.glyphHits;
+		total.glyphMisses += cache.second->m_statistics.glyphMisses;
+		total.kerningHits += cache.second->m_statistics.kerningHits;
+		total.kerningMisses += cache.second->m_statistics.kerningMisses;
+	}
+	return total;
+}
+
+const sfv::GlyphCache* sfv::GlyphCache::find(const sf::Font& font)
+{
+	const Registry& registry = getRegistry();
+	const auto found = registry.find(&font);
+	return found != registry.end() ? found->second.get() : nullptr;
+}
+
+const sf::Texture* sfv::GlyphCache::getTexture(const sf::Font& font, sf::Uint32 characterSize)
+{
+	// Bound fonts may never have been loaded, and creating a texture needs a graphics context
+	const GlyphCache* cache = find(font);
+	if (cache && !cache->m_ownedMetrics) {
+		return nullptr;
+	}
+	return &font.getTexture(characterSize);
+}
+
+sfv::FontMetrics& sfv::GlyphCache::getMetrics() const
+{
+	return *m_metrics;
+}
+
+sf::Glyph sfv::GlyphCache::getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness)
+{
+	Face& face = getFace(characterSize, bold, outlineThickness);
+	if (const sf::Glyph* glyph = findGlyph(face, codePoint)) {
+		++m_statistics.glyphHits;
+		return *glyph;
+	}
+	++m_statistics.glyphMisses;
+	++m_generation;
+	const sf::Glyph glyph = m_metrics->getGlyph(codePoint, characterSize, bold, outlineThickness);
+
+	// Latin-1 lives in a dense table indexed by the code point
+	if (codePoint < 256) {
+		if (face.latin.empty()) {
+			face.latin.resize(256);
+		}
+		face.latin[codePoint] = glyph;
+		face.loaded[codePoint] = true;
+		return glyph;
+	}
+
+	if (face.keys.empty()) {
+		growGlyphs(face);
+	}
+	std::size_t slot = hash(codePoint, face.keys.size());
+	while (face.keys[slot] != EMPTY_GLYPH) {
+		slot = (slot + 1) & (face.keys.size() - 1);
+	}
+	face.keys[slot] = codePoint;
+	face.glyphs[slot] = glyph;
+	if (++face.count * 2 > face.keys.size()) {
+		growGlyphs(face);
+	}
+	return glyph;
+}
+
+float sfv::GlyphCache::getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize)
+{
+	// sf::Font never kerns against the null character
+	if (first == 0 || second == 0) {
+		return 0.f;
+	}
+	const sf::Uint64 key = kerningKey(first, second, characterSize);
+	if (const float* kerning = findKerning(key)) {
+		++m_statistics.kerningHits;
+		return *kerning;
+	}
+	++m_statistics.kerningMisses;
+	const float kerning = m_metrics->getKerning(first, second, characterSize);
+	if (m_kerningKeys.empty()) {
+		growKerning();
+	}
+	std::size_t slot = hash(key, m_kerningKeys.size());
+	while (m_kerningKeys[slot] != EMPTY_KERNING) {
+		slot = (slot + 1) & (m_kerningKeys.size() - 1);
+	}
+	m_kerningKeys[slot] = key;
+	m_kerningValues[slot] = kerning;
+	if (++m_kerningCount * 2 > m_kerningKeys.size()) {
+		growKerning();
+	}
+	return kerning;
+}
+
+float sfv::GlyphCache::getLineSpacing(sf::Uint32 characterSize)
+{
+	return getSizeMetrics(characterSize).lineSpacing;
+}
+
+float sfv::GlyphCache::getUnderlinePosition(sf::Uint32 characterSize)
+{
+	return getSizeMetrics(characterSize).underlinePosition;
+}
+
+float sfv::GlyphCache::getUnderlineThickness(sf::Uint32 characterSize)
+{
+	return getSizeMetrics(characterSize).underlineThickness;
+}
+
+const sf::Glyph* sfv::GlyphCache::findGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness) const
+{
+	const std::size_t index = findFace(characterSize, bold, outlineThickness);
+	return index != m_faces.size() ? findGlyph(m_faces[index], codePoint) : nullptr;
+}
+
+const float* sfv::GlyphCache::findKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize) const
+{
+	if (first == 0 || second == 0) {
+		return &NO_KERNING;
+	}
+	return findKerning(kerningKey(first, second, characterSize));
+}
+
+const sfv::GlyphCache::SizeMetrics* sfv::GlyphCache::findSizeMetrics(sf::Uint32 characterSize) const
+{
+	for (const auto& size : m_sizes) {
+		if (size.characterSize == characterSize) {
+			return &size;
+		}
+	}
+	return nullptr;
+}
+
+std::size_t sfv::GlyphCache::getGeneration() const
+{
+	return m_generation;
+}
+
+const sfv::GlyphCache::Statistics& sfv::GlyphCache::getStatistics() const
+{
+	return m_statistics;
+}
+
+void sfv::GlyphCache::resetStatistics()
+{
+	m_statistics = Statistics();
+}
+
+void sfv::GlyphCache::clear()
+{
+	m_faces.clear();
+	m_lastFace = 0;
+	m_sizes.clear();
+	m_kerningKeys.clear();
+	m_kerningValues.clear();
+	m_kerningCount = 0;
+}
+
+sfv::GlyphCache::Face& sfv::GlyphCache::getFace(sf::Uint32 characterSize, bool bold, float outlineThickness)
+{
+	const std::size_t index = findFace(characterSize, bold, outlineThickness);
+	if (index != m_faces.size()) {
+		m_lastFace = index;
+		return m_faces[index];
+	}
+	m_faces.emplace_back();
+	Face& face = m_faces.back();
+	face.characterSize = characterSize;
+	face.bold = bold;
+	face.outlineThickness = outlineThickness;
+	face.count = 0;
+	m_lastFace = m_faces.size() - 1;
+	return face;
+}
+
+std::size_t sfv::GlyphCache::findFace(sf::Uint32 characterSize, bool bold, float outlineThickness) const
+{
+	// Runs are laid out one after the other, so the last face is usually the right one
+	if (m_lastFace < m_faces.size()) {
+		const Face& last = m_faces[m_lastFace];
+		if (last.characterSize == characterSize && last.bold == bold && last.outlineThickness == outlineThickness) {
+			return m_lastFace;
+		}
+	}
+	for (std::size_t index = 0; index != m_faces.size(); ++index) {
+		const Face& face = m_faces[index];
+		if (face.characterSize == characterSize && face.bold == bold && face.outlineThickness == outlineThickness) {
+			return index;
+		}
+	}
+	return m_faces.size();
+}
+
+const sf::Glyph* sfv::GlyphCache::findGlyph(const Face& face, sf::Uint32 codePoint) const
+{
+	if (codePoint < 256) {
+		return face.loaded[codePoint] ? &face.latin[codePoint] : nullptr;
+	}
+	if (face.keys.empty()) {
+		return nullptr;
+	}
+	std::size_t slot = hash(codePoint, face.keys.size());
+	while (face.keys[slot] != EMPTY_GLYPH) {
+		if (face.keys[slot] == codePoint) {
+			return &face.glyphs[slot];
+		}
+		slot = (slot + 1) & (face.keys.size() - 1);
+	}
+	return nullptr;
+}
+
+const float* sfv::GlyphCache::findKerning(sf::Uint64 key) const
+{
+	if (m_kerningKeys.empty()) {
+		return nullptr;
+	}
+	std::size_t slot = hash(key, m_kerningKeys.size());
+	while (m_kerningKeys[slot] != EMPTY_KERNING) {
+		if (m_kerningKeys[slot] == key) {
+			return &m_kerningValues[slot];
+		}
+		slot = (slot + 1) & (m_kerningKeys.size() - 1);
+	}
+	return nullptr;
+}
+
+sfv::GlyphCache::SizeMetrics sfv::GlyphCache::getSizeMetrics(sf::Uint32 characterSize)
+{
+	if (const SizeMetrics* size = findSizeMetrics(characterSize)) {
+		return *size;
+	}
+	m_sizes.push_back({ characterSize, m_metrics->getLineSpacing(characterSize), m_metrics->getUnderlinePosition(characterSize), m_metrics->getUnderlineThickness(characterSize) });
+	return m_sizes.back();
+}
+
+void sfv::GlyphCache::growGlyphs(Face& face)
+{
+	std::vector<sf::Uint32> keys(face.keys.empty() ? 64 : face.keys.size() * 2, EMPTY_GLYPH);
+	std::vector<sf::Glyph> glyphs(keys.size());
+	for (std::size_t index = 0; index != face.keys.size(); ++index) {
+		if (face.keys[index] == EMPTY_GLYPH) {
+			continue;
+		}
+		std::size_t slot = hash(face.keys[index], keys.size());
+		while (keys[slot] != EMPTY_GLYPH) {
+			slot = (slot + 1) & (keys.size() - 1);
+		}
+		keys[slot] = face.keys[index];
+		glyphs[slot] = face.glyphs[index];
+	}
+	face.keys.swap(keys);
+	face.glyphs.swap(glyphs);
+}
+
+void sfv::GlyphCache::growKerning()
+{
+	std::vector<sf::Uint64> keys(m_kerningKeys.empty() ? 256 : m_kerningKeys.size() * 2, EMPTY_KERNING);
+	std::vector<float> values(keys.size());
+	for (std::size_t index = 0; index != m_kerningKeys.size(); ++index) {
+		if (m_kerningKeys[index] == EMPTY_KERNING) {
+			continue;
+		}
+		std::size_t slot = hash(m_kerningKeys[index], keys.size());
+		while (keys[slot] != EMPTY_KERNING) {
+			slot = (slot + 1) & (keys.size() - 1);
+		}
+		keys[slot] = m_kerningKeys[index];
+		values[slot] = m_kerningValues[index];
+	}
+	m_kerningKeys.swap(keys);
+	m_kerningValues.swap(values);
+}
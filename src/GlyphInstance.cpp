@@ -0,0 +1,124 @@
+#include "GlyphInstance.h"
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	const sf::Uint32 EMPTY_SLOT = static_cast<sf::Uint32>(-1);
+
+	// Corners of a quad: top left, top right, bottom left, bottom right
+	void corners(const sfv::GlyphInstance& instance, const sfv::GlyphShape& shape, sf::Vertex (&quad)[4])
+	{
+		const sf::Vector2f& position = instance.position;
+		const float slant = instance.shear * shape.size.y;
+		const float u1 = static_cast<float>(shape.textureRect.left);
+		const float v1 = static_cast<float>(shape.textureRect.top);
+		const float u2 = static_cast<float>(shape.textureRect.left + shape.textureRect.width);
+		const float v2 = static_cast<float>(shape.textureRect.top + shape.textureRect.height);
+		quad[0] = sf::Vertex(position, instance.color, sf::Vector2f(u1, v1));
+		quad[1] = sf::Vertex(sf::Vector2f(position.x + shape.size.x, position.y), instance.color, sf::Vector2f(u2, v1));
+		quad[2] = sf::Vertex(sf::Vector2f(position.x - slant, position.y + shape.size.y), instance.color, sf::Vector2f(u1, v2));
+		quad[3] = sf::Vertex(sf::Vector2f(position.x + shape.size.x - slant, position.y + shape.size.y), instance.color, sf::Vector2f(u2, v2));
+	}
+}
+
+bool sfv::GlyphShape::operator==(const GlyphShape& shape) const
+{
+	return size == shape.size && textureRect == shape.textureRect;
+}
+
+std::size_t sfv::GlyphShapeTable::Hash::operator()(const GlyphShape& shape) const
+{
+	std::size_t hash = std::hash<float>()(shape.size.x);
+	const float fields[5] = { shape.size.y, static_cast<float>(shape.textureRect.left), static_cast<float>(shape.textureRect.top), static_cast<float>(shape.textureRect.width), static_cast<float>(shape.textureRect.height) };
+	for (float field : fields) {
+		hash ^= std::hash<float>()(field) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+sf::Uint32 sfv::GlyphShapeTable::intern(const GlyphShape& shape)
+{
+	if (m_slots.empty()) {
+		grow();
+	}
+	const std::size_t mask = m_slots.size() - 1;
+	std::size_t slot = Hash()(shape) & mask;
+	while (m_slots[slot] != EMPTY_SLOT) {
+		if (m_shapes[m_slots[slot]] == shape) {
+			return m_slots[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+	const sf::Uint32 index = static_cast<sf::Uint32>(m_shapes.size());
+	m_shapes.push_back(shape);
+	m_slots[slot] = index;
+	if (m_shapes.size() * 2 > m_slots.size()) {
+		grow();
+	}
+	return index;
+}
+
+const sfv::GlyphShape& sfv::GlyphShapeTable::operator[](sf::Uint32 index) const
+{
+	return m_shapes[index];
+}
+
+std::size_t sfv::GlyphShapeTable::size() const
+{
+	return m_shapes.size();
+}
+
+std::size_t sfv::GlyphShapeTable::getByteSize() const
+{
+	return m_shapes.capacity() * sizeof(GlyphShape) + m_slots.capacity() * sizeof(sf::Uint32);
+}
+
+void sfv::GlyphShapeTable::clear()
+{
+	m_shapes.clear();
+	std::fill(m_slots.begin(), m_slots.end(), EMPTY_SLOT);
+}
+
+void sfv::GlyphShapeTable::grow()
+{
+	m_slots.assign(m_slots.empty() ? 64 : m_slots.size() * 2, EMPTY_SLOT);
+	const std::size_t mask = m_slots.size() - 1;
+	for (sf::Uint32 index = 0; index != m_shapes.size(); ++index) {
+		std::size_t slot = Hash()(m_shapes[index]) & mask;
+		while (m_slots[slot] != EMPTY_SLOT) {
+			slot = (slot + 1) & mask;
+		}
+		m_slots[slot] = index;
+	}
+}
+
+void sfv::appendTriangles(const GlyphInstance& instance, const GlyphShape& shape, std::vector<sf::Vertex>& vertices)
+{
+	sf::Vertex quad[4];
+	corners(instance, shape, quad);
+	vertices.push_back(quad[0]);
+	vertices.push_back(quad[1]);
+	vertices.push_back(quad[2]);
+	vertices.push_back(quad[2]);
+	vertices.push_back(quad[1]);
+	vertices.push_back(quad[3]);
+}
+
+void sfv::appendQuad(const GlyphInstance& instance, const GlyphShape& shape, std::vector<sf::Vertex>& vertices)
+{
+	sf::Vertex quad[4];
+	corners(instance, shape, quad);
+	vertices.insert(vertices.end(), quad, quad + 4);
+}
+
+const std::vector<sf::Uint32>& sfv::getQuadIndices(std::size_t quadCount)
+{
+	static std::vector<sf::Uint32> indices;
+	for (std::size_t quad = indices.size() / 6; quad < quadCount; ++quad) {
+		const sf::Uint32 first = static_cast<sf::Uint32>(quad * 4);
+		const sf::Uint32 pattern[6] = { first, first + 1, first + 2, first + 2, first + 1, first + 3 };
+		indices.insert(indices.end(), pattern, pattern + 6);
+	}
+	return indices;
+}
@@ -0,0 +1,185 @@
+#include "LayoutCache.h"
+#include "GlyphCache.h"
+#include "StyleTable.h"
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+	std::size_t mix(std::size_t seed, std::size_t value)
+	{
+		return seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+	}
+
+	template <typename T>
+	std::size_t capacityBytes(const std::vector<T>& vector)
+	{
+		return vector.capacity() * sizeof(T);
+	}
+
+	// Entries live for long, so they give back what layout reserved past their size
+	void shrink(sfv::TextLayout::Result& result)
+	{
+		result.lines.shrink_to_fit();
+		result.words.shrink_to_fit();
+		result.offsets.shrink_to_fit();
+		result.instances.shrink_to_fit();
+		result.outlineInstances.shrink_to_fit();
+		result.segments.shrink_to_fit();
+	}
+
+	std::size_t byteSize(const sfv::TextLayout::Result& result)
+	{
+		return sizeof(result) + capacityBytes(result.lines) + capacityBytes(result.words) + capacityBytes(result.offsets)
+			+ capacityBytes(result.instances) + capacityBytes(result.outlineInstances) + capacityBytes(result.segments) + result.shapes.getByteSize();
+	}
+}
+
+sfv::LayoutCache::LayoutCache(std::size_t capacity)
+	: m_capacity(capacity),
+	m_statistics()
+{
+}
+
+sfv::LayoutCache& sfv::LayoutCache::getDefault()
+{
+	// Never destroyed, texts with static storage may outlive it otherwise
+	static LayoutCache* cache = new LayoutCache();
+	return *cache;
+}
+
+void sfv::LayoutCache::setCapacity(std::size_t bytes)
+{
+	m_capacity = bytes;
+	evict();
+}
+
+std::size_t sfv::LayoutCache::getCapacity() const
+{
+	return m_capacity;
+}
+
+sfv::LayoutCache::Geometry sfv::LayoutCache::get(const TextStorage& string, const ChunkTree& chunks, float maxWidth)
+{
+	const std::size_t key = hash(string, chunks, maxWidth);
+	const auto range = m_lookup.equal_range(key);
+	for (auto found = range.first; found != range.second; ++found) {
+		if (matches(*found->second, string, chunks, maxWidth)) {
+			m_entries.splice(m_entries.begin(), m_entries, found->second);
+			++m_statistics.hits;
+			return found->second->geometry;
+		}
+	}
+	++m_statistics.misses;
+
+	std::shared_ptr<TextLayout::Result> result = std::make_shared<TextLayout::Result>();
+	TextLayout(string, chunks, maxWidth).layout(*result);
+	shrink(*result);
+	for (auto& segment : result->segments) {
+		segment.texture = GlyphCache::getTexture(*segment.font, segment.characterSize);
+	}
+
+	Entry entry;
+	entry.hash = key;
+	entry.maxWidth = maxWidth;
+	entry.characters.reserve(string.getSize());
+	for (const sf::Uint32 character : string) {
+		entry.characters.push_back(character);
+	}
+	entry.runs.reserve(chunks.size());
+	for (const ChunkTree::Run& run : chunks) {
+		entry.runs.push_back(chunks.getStyle(run));
+		entry.runs.back().length = run.length;
+	}
+	entry.geometry = result;
+	entry.bytes = sizeof(Entry) + capacityBytes(entry.characters) + capacityBytes(entry.runs) + byteSize(*result);
+
+	m_statistics.bytes += entry.bytes;
+	++m_statistics.entries;
+	m_entries.push_front(std::move(entry));
+	m_lookup.emplace(key, m_entries.begin());
+	evict();
+	return result;
+}
+
+void sfv::LayoutCache::clear()
+{
+	m_lookup.clear();
+	m_entries.clear();
+	m_statistics.entries = 0;
+	m_statistics.bytes = 0;
+}
+
+sfv::LayoutCache::Statistics sfv::LayoutCache::getStatistics() const
+{
+	return m_statistics;
+}
+
+float sfv::LayoutCache::getHitRate() const
+{
+	const Statistics statistics = getStatistics();
+	const std::size_t lookups = statistics.hits + statistics.misses;
+	return lookups != 0 ? static_cast<float>(statistics.hits) / static_cast<float>(lookups) : 0.f;
+}
+
+void sfv::LayoutCache::resetStatistics()
+{
+	m_statistics.hits = 0;
+	m_statistics.misses = 0;
+	m_statistics.evictions = 0;
+}
+
+std::size_t sfv::LayoutCache::hash(const TextStorage& string, const ChunkTree& chunks, float maxWidth)
+{
+	std::uint32_t width;
+	std::memcpy(&width, &maxWidth, sizeof(width));
+	std::size_t seed = width;
+	for (const sf::Uint32 character : string) {
+		seed = mix(seed, character);
+	}
+	for (const ChunkTree::Run& run : chunks) {
+		seed = mix(seed, run.length);
+		seed = mix(seed, StyleTable::hash(chunks.getStyle(run)));
+	}
+	return seed;
+}
+
+bool sfv::LayoutCache::matches(const Entry& entry, const TextStorage& string, const ChunkTree& chunks, float maxWidth)
+{
+	if (entry.maxWidth != maxWidth || entry.characters.size() != string.getSize() || entry.runs.size() != chunks.size()) {
+		return false;
+	}
+	auto character = entry.characters.begin();
+	for (const sf::Uint32 current : string) {
+		if (*character++ != current) {
+			return false;
+		}
+	}
+	auto run = entry.runs.begin();
+	for (const ChunkTree::Run& current : chunks) {
+		if (run->length != current.length || !(*run == chunks.getStyle(current))) {
+			return false;
+		}
+		++run;
+	}
+	return true;
+}
+
+void sfv::LayoutCache::evict()
+{
+	while (m_statistics.bytes > m_capacity && !m_entries.empty()) {
+		const auto last = std::prev(m_entries.end());
+		const auto range = m_lookup.equal_range(last->hash);
+		for (auto found = range.first; found != range.second; ++found) {
+			if (found->second == last) {
+				m_lookup.erase(found);
+				break;
+			}
+		}
+		m_statistics.bytes -= last->bytes;
+		--m_statistics.entries;
+		++m_statistics.evictions;
+		m_entries.pop_back();
+	}
+}
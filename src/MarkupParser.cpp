@@ -0,0 +1,267 @@
+#include "MarkupParser.h"
+#include <SFML/Graphics/Text.hpp>
+#include <algorithm>
+
+namespace
+{
+	// Longer brackets are left as text without looking for their end
+	const std::ptrdiff_t MAX_TAG_LENGTH = 64;
+
+	const sf::Uint32 MAX_CHARACTER_SIZE = 1024;
+
+	bool equals(const sf::Uint32* begin, const sf::Uint32* end, const char* name)
+	{
+		for (; begin != end; ++begin, ++name) {
+			if (*name == '\0' || *begin != static_cast<unsigned char>(*name)) {
+				return false;
+			}
+		}
+		return *name == '\0';
+	}
+
+	int hexDigit(sf::Uint32 character)
+	{
+		if (character >= '0' && character <= '9') {
+			return static_cast<int>(character - '0');
+		}
+		if (character >= 'a' && character <= 'f') {
+			return static_cast<int>(character - 'a' + 10);
+		}
+		if (character >= 'A' && character <= 'F') {
+			return static_cast<int>(character - 'A' + 10);
+		}
+		return -1;
+	}
+
+	bool parseColor(const sf::Uint32* begin, const sf::Uint32* end, sf::Color& color)
+	{
+		if (begin != end && *begin == '#') {
+			const std::ptrdiff_t digits = end - begin - 1;
+			if (digits != 6 && digits != 8) {
+				return false;
+			}
+			sf::Uint8 channels[4] = { 0, 0, 0, 255 };
+			for (std::ptrdiff_t channel = 0; channel != digits / 2; ++channel) {
+				const int high = hexDigit(begin[1 + channel * 2]);
+				const int low = hexDigit(begin[2 + channel * 2]);
+				if (high < 0 || low < 0) {
+					return false;
+				}
+				channels[channel] = static_cast<sf::Uint8>(high * 16 + low);
+			}
+			color = sf::Color(channels[0], channels[1], channels[2], channels[3]);
+			return true;
+		}
+		static const std::pair<const char*, const sf::Color*> names[] = {
+			{ "black", &sf::Color::Black }, { "white", &sf::Color::White }, { "red", &sf::Color::Red },
+			{ "green", &sf::Color::Green }, { "blue", &sf::Color::Blue }, { "yellow", &sf::Color::Yellow },
+			{ "magenta", &sf::Color::Magenta }, { "cyan", &sf::Color::Cyan }, { "transparent", &sf::Color::Transparent }
+		};
+		for (const auto& name : names) {
+			if (equals(begin, end, name.first)) {
+				color = *name.second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Digits with an optional fraction
+	bool parseNumber(const sf::Uint32* begin, const sf::Uint32* end, float& number)
+	{
+		if (begin == end || end - begin > 16) {
+			return false;
+		}
+		float value = 0.f;
+		float scale = 0.f;
+		for (; begin != end; ++begin) {
+			if (*begin == '.' && scale == 0.f) {
+				scale = 1.f;
+			}
+			else if (*begin >= '0' && *begin <= '9') {
+				value = value * 10.f + static_cast<float>(*begin - '0');
+				scale *= 10.f;
+			}
+			else {
+				return false;
+			}
+		}
+		number = scale > 1.f ? value / scale : value;
+		return true;
+	}
+}
+
+void sfv::MarkupParser::parse(const sf::String& markup, const FontRegistry& fonts, const Chunk& base)
+{
+	m_open.clear();
+	m_text.clear();
+	m_chunks.clear();
+	m_current = base;
+	m_current.length = 0;
+	m_text.reserve(markup.getSize());
+
+	const sf::Uint32* position = markup.getData();
+	const sf::Uint32* const end = position + markup.getSize();
+	while (position != end) {
+		// Plain text up to the next bracket goes in at once
+		const sf::Uint32* bracket = std::find(position, end, static_cast<sf::Uint32>('['));
+		m_text.append(position, bracket);
+		m_current.length += static_cast<std::size_t>(bracket - position);
+		if (bracket == end) {
+			break;
+		}
+		position = bracket + 1;
+		if (position != end && *position == '[') {
+			++position;
+		}
+		else {
+			const sf::Uint32* limit = bracket + std::min(end - bracket, MAX_TAG_LENGTH);
+			const sf::Uint32* close = std::find_if(position, limit, [](sf::Uint32 character) {
+				return character == ']' || character == '[' || character == '\n';
+			});
+			if (close != limit && *close == ']' && applyTag(position, close, fonts)) {
+				position = close + 1;
+				continue;
+			}
+		}
+		m_text.push_back('[');
+		++m_current.length;
+	}
+	flush();
+}
+
+const std::basic_string<sf::Uint32>& sfv::MarkupParser::getText() const
+{
+	return m_text;
+}
+
+const std::vector<sfv::Chunk>& sfv::MarkupParser::getChunks() const
+{
+	return m_chunks;
+}
+
+bool sfv::MarkupParser::applyTag(const sf::Uint32* begin, const sf::Uint32* end, const FontRegistry& fonts)
+{
+	const bool closing = begin != end && *begin == '/';
+	const sf::Uint32* name = closing ? begin + 1 : begin;
+	const sf::Uint32* value = std::find(name, end, static_cast<sf::Uint32>('='));
+	Tag tag;
+	if (equals(name, value, "b")) {
+		tag = Bold;
+	}
+	else if (equals(name, value, "i")) {
+		tag = Italic;
+	}
+	else if (equals(name, value, "u")) {
+		tag = Underlined;
+	}
+	else if (equals(name, value, "s")) {
+		tag = StrikeThrough;
+	}
+	else if (equals(name, value, "color")) {
+		tag = Color;
+	}
+	else if (equals(name, value, "outline")) {
+		tag = Outline;
+	}
+	else if (equals(name, value, "size")) {
+		tag = Size;
+	}
+	else if (equals(name, value, "font")) {
+		tag = Font;
+	}
+	else {
+		return false;
+	}
+
+	if (closing) {
+		if (value != end) {
+			return false;
+		}
+		closeTag(tag);
+		return true;
+	}
+
+	// Only the attribute tags take a value
+	const bool hasValue = value != end;
+	if (hasValue != (tag >= Color)) {
+		return false;
+	}
+	if (hasValue) {
+		++value;
+	}
+	Chunk next = m_current;
+	switch (tag) {
+	case Bold:
+		next.style |= sf::Text::Style::Bold;
+		break;
+	case Italic:
+		next.style |= sf::Text::Style::Italic;
+		break;
+	case Underlined:
+		next.style |= sf::Text::Style::Underlined;
+		break;
+	case StrikeThrough:
+		next.style |= sf::Text::Style::StrikeThrough;
+		break;
+	case Color:
+		if (!parseColor(value, end, next.fillColor)) {
+			return false;
+		}
+		break;
+	case Outline: {
+		const sf::Uint32* comma = std::find(value, end, static_cast<sf::Uint32>(','));
+		if (!parseColor(value, comma, next.outlineColor) || (comma != end && !parseNumber(comma + 1, end, next.outlineThickness))) {
+			return false;
+		}
+		break;
+	}
+	case Size: {
+		float size = 0.f;
+		if (!parseNumber(value, end, size) || size < 1.f || size > static_cast<float>(MAX_CHARACTER_SIZE)) {
+			return false;
+		}
+		next.characterSize = static_cast<sf::Uint32>(size);
+		break;
+	}
+	case Font:
+		next.font = fonts.find(value, static_cast<std::size_t>(end - value));
+		if (!next.font) {
+			return false;
+		}
+		break;
+	}
+
+	flush();
+	m_open.push_back({ tag, m_current });
+	next.length = 0;
+	m_current = next;
+	return true;
+}
+
+void sfv::MarkupParser::closeTag(Tag tag)
+{
+	// A closing tag nobody opened is dropped
+	for (std::size_t index = m_open.size(); index-- != 0;) {
+		if (m_open[index].tag == tag) {
+			flush();
+			m_current = m_open[index].previous;
+			m_open.resize(index);
+			return;
+		}
+	}
+}
+
+void sfv::MarkupParser::flush()
+{
+	if (m_current.length == 0) {
+		return;
+	}
+	if (!m_chunks.empty() && m_chunks.back() == m_current) {
+		m_chunks.back().length += m_current.length;
+	}
+	else {
+		m_chunks.push_back(m_current);
+	}
+	m_current.length = 0;
+}
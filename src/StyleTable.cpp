@@ -0,0 +1,152 @@
+#include "StyleTable.h"
+#include <cstring>
+
+namespace
+{
+	const sfv::StyleTable::Id EMPTY_SLOT = static_cast<sfv::StyleTable::Id>(-1);
+
+	std::size_t mix(std::size_t seed, std::size_t value)
+	{
+		return seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+	}
+}
+
+sfv::StyleTable::StyleTable()
+	: m_count(0)
+{
+}
+
+sfv::StyleTable& sfv::StyleTable::getDefault()
+{
+	// Never destroyed, texts with static storage may outlive it otherwise
+	static StyleTable* table = new StyleTable();
+	return *table;
+}
+
+sfv::StyleTable::Id sfv::StyleTable::acquire(const Chunk& chunk)
+{
+	if (m_slots.empty()) {
+		grow();
+	}
+	const std::size_t key = hash(chunk);
+	std::size_t slot = key & (m_slots.size() - 1);
+	while (m_slots[slot] != EMPTY_SLOT) {
+		const Id id = m_slots[slot];
+		if (m_hashes[id] == key && m_styles[id] == chunk) {
+			++m_references[id];
+			return id;
+		}
+		slot = (slot + 1) & (m_slots.size() - 1);
+	}
+
+	Id id;
+	if (!m_free.empty()) {
+		id = m_free.back();
+		m_free.pop_back();
+	}
+	else {
+		id = static_cast<Id>(m_styles.size());
+		m_styles.emplace_back();
+		m_hashes.emplace_back();
+		m_references.emplace_back();
+	}
+	m_styles[id] = chunk;
+	m_styles[id].length = 0;
+	m_hashes[id] = key;
+	m_references[id] = 1;
+	m_slots[slot] = id;
+	if (++m_count * 2 > m_slots.size()) {
+		grow();
+	}
+	return id;
+}
+
+sfv::StyleTable::Id sfv::StyleTable::derive(Id id, const ChunkBuilder& data)
+{
+	Chunk chunk = m_styles[id];
+	data.apply(chunk);
+	return acquire(chunk);
+}
+
+void sfv::StyleTable::retain(Id id)
+{
+	++m_references[id];
+}
+
+void sfv::StyleTable::release(Id id)
+{
+	if (--m_references[id] != 0) {
+		return;
+	}
+	std::size_t slot = m_hashes[id] & (m_slots.size() - 1);
+	while (m_slots[slot] != id) {
+		slot = (slot + 1) & (m_slots.size() - 1);
+	}
+	erase(slot);
+	m_free.push_back(id);
+	--m_count;
+}
+
+const sfv::Chunk& sfv::StyleTable::operator[](Id id) const
+{
+	return m_styles[id];
+}
+
+std::size_t sfv::StyleTable::size() const
+{
+	return m_count;
+}
+
+std::size_t sfv::StyleTable::hash(const Chunk& chunk)
+{
+	// Same attributes as Chunk::operator==, with both zeros of the thickness alike
+	std::uint32_t thickness = 0;
+	if (chunk.outlineThickness != 0.f) {
+		std::memcpy(&thickness, &chunk.outlineThickness, sizeof(thickness));
+	}
+	std::size_t seed = chunk.fillColor.toInteger();
+	seed = mix(seed, chunk.outlineColor.toInteger());
+	seed = mix(seed, chunk.lineColor.toInteger());
+	seed = mix(seed, thickness);
+	seed = mix(seed, chunk.style);
+	seed = mix(seed, chunk.characterSize);
+	seed = mix(seed, reinterpret_cast<std::uintptr_t>(chunk.font));
+	return seed;
+}
+
+void sfv::StyleTable::grow()
+{
+	std::vector<Id> slots(m_slots.empty() ? 16 : m_slots.size() * 2, EMPTY_SLOT);
+	for (const Id id : m_slots) {
+		if (id == EMPTY_SLOT) {
+			continue;
+		}
+		std::size_t slot = m_hashes[id] & (slots.size() - 1);
+		while (slots[slot] != EMPTY_SLOT) {
+			slot = (slot + 1) & (slots.size() - 1);
+		}
+		slots[slot] = id;
+	}
+	m_slots.swap(slots);
+}
+
+void sfv::StyleTable::erase(std::size_t slot)
+{
+	// Styles probed past the hole move into it unless their own slot lies between the two
+	const std::size_t mask = m_slots.size() - 1;
+	std::size_t next = slot;
+	while (true) {
+		next = (next + 1) & mask;
+		const Id id = m_slots[next];
+		if (id == EMPTY_SLOT) {
+			break;
+		}
+		const std::size_t home = m_hashes[id] & mask;
+		const bool stays = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+		if (!stays) {
+			m_slots[slot] = id;
+			slot = next;
+		}
+	}
+	m_slots[slot] = EMPTY_SLOT;
+}
@@ -0,0 +1,796 @@
+#include "TextLayout.h"
+#include "GlyphCache.h"
+#include <SFML/Graphics/Text.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+////////////////////////////////////////////////////////////
+// Source Author: Laurent Gomila
+// Taken from SFML-2.4.1 Text.cpp
+// Edits made to the source:
+//    -Modified addLine & addGlyphQuad to emit one sfv::GlyphInstance per quad
+//    -Modified ensureGeometryUpdate to work with varying styles, fonts, and sizes.
+////////////////////////////////////////////////////////////
+namespace
+{
+	// Add an underline or strikethrough line to the instance array, if there is one
+	void addLine(float xOffset, std::vector<sfv::GlyphInstance>* instances, sfv::GlyphShapeTable* shapes, float lineLength, float lineTop, const sf::Color& color, float offset, float thickness, float outlineThickness = 0)
+	{
+		if (!instances) {
+			return;
+		}
+		float top = std::roundf(lineTop + offset - (thickness / 2) + 0.5f);
+		float bottom = top + std::floor(thickness + 0.5f);
+
+		const float left = -outlineThickness + xOffset;
+		const float right = lineLength + outlineThickness + xOffset;
+		const sfv::GlyphShape shape{ sf::Vector2f(right - left, (bottom + outlineThickness) - (top - outlineThickness)), sf::IntRect(1, 1, 0, 0) };
+		instances->push_back({ sf::Vector2f(left, top - outlineThickness), shapes->intern(shape), color, 0.f });
+	}
+
+	// Add a glyph quad to the instance array, if there is one
+	void addGlyphQuad(std::vector<sfv::GlyphInstance>* instances, sfv::GlyphShapeTable* shapes, sf::Vector2f position, const sf::Color& color, const sf::Glyph& glyph, float italic, float outlineThickness = 0)
+	{
+		if (!instances) {
+			return;
+		}
+		const float left = glyph.bounds.left;
+		const float top = glyph.bounds.top;
+
+		const sfv::GlyphShape shape{ sf::Vector2f(glyph.bounds.width, glyph.bounds.height), glyph.textureRect };
+		instances->push_back({ sf::Vector2f(position.x + left - italic * top - outlineThickness, position.y + top - outlineThickness), shapes->intern(shape), color, italic });
+	}
+
+	// Metrics of the font of a run, all zero without one.
+	// Given a miss flag only the cache is read, and metrics missing from it read as zero and set the flag.
+	class FontMetricsLookup {
+	private:
+		sfv::GlyphCache* m_cache;
+		const sfv::GlyphCache* m_found;
+		std::atomic<bool>* m_missed;
+
+		void miss() const
+		{
+			m_missed->store(true, std::memory_order_relaxed);
+		}
+
+		sfv::GlyphCache::SizeMetrics findSizeMetrics(sf::Uint32 characterSize) const
+		{
+			if (const sfv::GlyphCache::SizeMetrics* size = m_found->findSizeMetrics(characterSize)) {
+				return *size;
+			}
+			miss();
+			return sfv::GlyphCache::SizeMetrics();
+		}
+	public:
+		FontMetricsLookup(const sf::Font* font, std::atomic<bool>* missed)
+			: m_cache(font && !missed ? &sfv::GlyphCache::get(*font) : nullptr),
+			m_found(font && missed ? sfv::GlyphCache::find(*font) : nullptr),
+			m_missed(missed)
+		{
+			if (font && missed && !m_found) {
+				miss();
+			}
+		}
+
+		sf::Glyph getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f) const
+		{
+			if (m_cache) {
+				return m_cache->getGlyph(codePoint, characterSize, bold, outlineThickness);
+			}
+			if (m_found) {
+				if (const sf::Glyph* glyph = m_found->findGlyph(codePoint, characterSize, bold, outlineThickness)) {
+					return *glyph;
+				}
+				miss();
+			}
+			return sf::Glyph();
+		}
+
+		float getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize) const
+		{
+			if (m_cache) {
+				return m_cache->getKerning(first, second, characterSize);
+			}
+			if (m_found) {
+				if (const float* kerning = m_found->findKerning(first, second, characterSize)) {
+					return *kerning;
+				}
+				miss();
+			}
+			return 0.f;
+		}
+
+		float getLineSpacing(sf::Uint32 characterSize) const
+		{
+			return m_cache ? m_cache->getLineSpacing(characterSize) : m_found ? findSizeMetrics(characterSize).lineSpacing : 0.f;
+		}
+
+		float getUnderlinePosition(sf::Uint32 characterSize) const
+		{
+			return m_cache ? m_cache->getUnderlinePosition(characterSize) : m_found ? findSizeMetrics(characterSize).underlinePosition : 0.f;
+		}
+
+		float getUnderlineThickness(sf::Uint32 characterSize) const
+		{
+			return m_cache ? m_cache->getUnderlineThickness(characterSize) : m_found ? findSizeMetrics(characterSize).underlineThickness : 0.f;
+		}
+	};
+
+	// Paragraphs are handed to the workers in tasks of at least this many characters
+	const std::size_t PARAGRAPH_TASK_LENGTH = 4096;
+
+	// Lines, quads and runs of consecutive paragraphs laid out by one worker
+	struct Paragraphs {
+		std::size_t begin;
+		std::size_t end;
+		std::vector<sfv::TextLayout::Line> lines;
+		std::vector<sfv::TextLayout::Word> words;
+		std::size_t lineOffset;
+		std::size_t wordOffset;
+		sfv::GlyphShapeTable shapes;
+		std::vector<sfv::GlyphInstance> instances;
+		std::vector<sfv::GlyphInstance> outlineInstances;
+		std::vector<sfv::TextLayout::Segment> segments;
+		std::size_t instanceOffset;
+		std::size_t outlineOffset;
+		std::size_t segmentOffset;
+		std::vector<sf::Uint32> remap;
+	};
+}
+
+sfv::TextLayout::TextLayout(const TextStorage& string, const ChunkTree& chunks, float maxWidth, const GlyphAttributes& glyphs, std::atomic<bool>* missed)
+	: m_string(string),
+	m_chunks(chunks),
+	m_maxWidth(maxWidth),
+	m_glyphs(glyphs),
+	m_missed(missed)
+{
+}
+
+void sfv::TextLayout::layout(Result& result, WorkerPool* pool) const
+{
+	result.lines.clear();
+	result.words.clear();
+	result.offsets.clear();
+	result.instances.clear();
+	result.outlineInstances.clear();
+	result.segments.clear();
+	result.shapes.clear();
+	result.bounds = sf::FloatRect();
+	if (m_string.isEmpty() || m_chunks.empty()) {
+		return;
+	}
+
+	std::vector<std::size_t> starts(1, 0U);
+	const std::size_t size = m_string.getSize();
+	for (std::size_t newline = m_string.find(L'\n', 0U, size); newline != size; newline = m_string.find(L'\n', newline + 1, size)) {
+		starts.push_back(newline + 1);
+	}
+	if (pool) {
+		warm(0U, size);
+	}
+	layoutLines(starts, nullptr, pool, result.shapes, result.lines, result.instances, result.outlineInstances, result.segments, result.words, result.offsets);
+	result.bounds = getBounds(result.lines);
+}
+
+void sfv::TextLayout::measureLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::size_t maxLength) const
+{
+	const std::size_t size = m_string.getSize();
+	line.characterSize = 0U;
+	line.height = 0.f;
+
+	// An empty trailing line takes its metrics from the newline that opened it
+	if (line.start == size) {
+		const Chunk& last = m_chunks.getStyle(m_chunks.back());
+		line.length = 0U;
+		line.characterSize = last.characterSize;
+		line.height = FontMetricsLookup(last.font, m_missed).getLineSpacing(last.characterSize);
+		return;
+	}
+
+	// Look for the newline and the tallest run in the same walk over the runs
+	std::size_t end = maxLength < size - line.start ? line.start + maxLength : size;
+	for (; chunk != m_chunks.end() && chunkStart < end; chunkStart += chunk->length, ++chunk) {
+		const std::size_t stop = std::min(chunkStart + chunk->length, end);
+		const std::size_t newline = m_string.find(L'\n', std::max(chunkStart, line.start), stop);
+		if (newline != stop) {
+			end = newline + 1;
+		}
+		const Chunk& chunkData = m_chunks.getStyle(*chunk);
+		if (chunkData.font) {
+			line.characterSize = std::max(line.characterSize, chunkData.characterSize);
+			line.height = std::max(line.height, FontMetricsLookup(chunkData.font, m_missed).getLineSpacing(chunkData.characterSize));
+		}
+	}
+	line.length = end - line.start;
+}
+
+void sfv::TextLayout::measureParagraph(std::size_t start, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::vector<Line>& lines, std::vector<Word>& words) const
+{
+	if (m_maxWidth <= 0.f) {
+		Line line;
+		line.start = start;
+		line.wordBegin = words.size();
+		measureLine(line, chunk, chunkStart);
+		lines.push_back(line);
+		return;
+	}
+	const std::size_t wordBegin = words.size();
+	measureWords(start, chunk, chunkStart, words);
+	measureLines(start, words.data() + wordBegin, words.size() - wordBegin, wordBegin, chunk, chunkStart, lines);
+}
+
+void sfv::TextLayout::measureWords(std::size_t start, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::vector<Word>& words) const
+{
+	// Follows the pen of layoutLine, which wraps lines after whitespace
+	const std::size_t size = m_string.getSize();
+	sf::Uint32 prevChar = start != 0 ? m_string[start - 1] : 0U;
+	bool whitespace = true;
+	const std::size_t wordBegin = words.size();
+	std::size_t offset = start;
+	TextStorage::const_iterator character = m_string.at(start);
+	for (; chunk != m_chunks.end() && offset < size; chunkStart += chunk->length, ++chunk) {
+		const Chunk& chunkData = m_chunks.getStyle(*chunk);
+		const std::size_t stop = std::min(size, chunkStart + chunk->length);
+		const FontMetricsLookup glyphs(chunkData.font, m_missed);
+		const bool bold = (chunkData.style & sf::Text::Style::Bold) != 0;
+		const float hspace = glyphs.getGlyph(L' ', chunkData.characterSize, bold).advance;
+		for (; offset != stop; ++offset, ++character) {
+			const sf::Uint32 curChar = *character;
+			const bool space = curChar == L' ' || curChar == L'\t' || curChar == L'\n';
+			if (words.size() == wordBegin || (whitespace && !space)) {
+				words.push_back({ 0U, 0.f, 0.f });
+			}
+			whitespace = space;
+			Word& word = words.back();
+			++word.length;
+
+			// Characters without a font take no room
+			if (!chunkData.font) {
+				if (curChar == L'\n') {
+					return;
+				}
+				continue;
+			}
+			const float kerning = glyphs.getKerning(prevChar, curChar, chunkData.characterSize);
+			prevChar = curChar;
+			switch (curChar)
+			{
+			case L'\n':
+				word.whitespace += kerning;
+				return;
+			case L' ':
+				word.whitespace += kerning + hspace;
+				break;
+			case L'\t':
+				word.whitespace += kerning + hspace * 4;
+				break;
+			default:
+				word.advance += kerning + glyphs.getGlyph(curChar, chunkData.characterSize, bold).advance;
+				break;
+			}
+		}
+	}
+}
+
+void sfv::TextLayout::measureLines(std::size_t start, const Word* words, std::size_t count, std::size_t wordBegin, ChunkTree::const_iterator chunk, std::size_t chunkStart, std::vector<Line>& lines) const
+{
+	// Only the empty line closing the string has no words
+	if (count == 0) {
+		Line line;
+		line.start = start;
+		line.wordBegin = wordBegin;
+		measureLine(line, chunk, chunkStart);
+		lines.push_back(line);
+		return;
+	}
+	std::size_t word = 0;
+	while (word != count) {
+		Line line;
+		line.start = start;
+		line.wordBegin = wordBegin + word;
+
+		// Trailing whitespace hangs past the maximum width
+		std::size_t length = 0U;
+		float width = 0.f;
+		do {
+			length += words[word].length;
+			width += words[word].advance + words[word].whitespace;
+			++word;
+		} while (word != count && width + words[word].advance <= m_maxWidth);
+
+		for (; chunk != m_chunks.end() && chunkStart + chunk->length <= start; ++chunk) {
+			chunkStart += chunk->length;
+		}
+		measureLine(line, chunk, chunkStart, length);
+		lines.push_back(line);
+		start += length;
+	}
+}
+
+void sfv::TextLayout::warm(std::size_t start, std::size_t end) const
+{
+	// Lines are measured with every run they hold, so every font needs a cache even outside the range
+	for (const ChunkTree::Run& run : m_chunks) {
+		const Chunk& chunk = m_chunks.getStyle(run);
+		if (chunk.font) {
+			GlyphCache::get(*chunk.font).getLineSpacing(chunk.characterSize);
+		}
+	}
+
+	end = std::min(end, m_string.getSize());
+	if (start >= end) {
+		return;
+	}
+	const auto location = m_chunks.find(start);
+	std::size_t chunkStart = location.start;
+	// A character kerns against the last one before it with a font, or against the character before its line
+	// when no character between them has one. Lines can start anywhere, so it kerns against each of those too.
+	sf::Uint32 previous = start != 0 ? m_string[start - 1] : 0U;
+	std::vector<sf::Uint32> fontless;
+	TextStorage::const_iterator character = m_string.at(start);
+	for (auto chunk = m_chunks.at(location.index); chunk != m_chunks.end() && chunkStart < end; chunkStart += chunk->length, ++chunk) {
+		const Chunk& chunkData = m_chunks.getStyle(*chunk);
+		const std::size_t stop = std::min(end, chunkStart + chunk->length);
+		if (!chunkData.font) {
+			for (std::size_t i = std::max(start, chunkStart); i < stop; ++i, ++character) {
+				fontless.push_back(*character);
+			}
+			continue;
+		}
+		GlyphCache& glyphs = GlyphCache::get(*chunkData.font);
+		const sf::Uint32 characterSize = chunkData.characterSize;
+		const bool bold = (chunkData.style & sf::Text::Style::Bold) != 0;
+		glyphs.getGlyph(L'x', characterSize, bold);
+		glyphs.getGlyph(L' ', characterSize, bold);
+
+		for (std::size_t i = std::max(start, chunkStart); i < stop; ++i, ++character) {
+			const sf::Uint32 current = *character;
+			glyphs.getKerning(previous, current, characterSize);
+			for (const sf::Uint32 before : fontless) {
+				glyphs.getKerning(before, current, characterSize);
+			}
+			fontless.clear();
+			previous = current;
+			if (current == L'\n' || current == L' ' || current == L'\t') {
+				continue;
+			}
+			glyphs.getGlyph(current, characterSize, bold);
+			if (chunkData.outlineThickness != 0) {
+				glyphs.getGlyph(current, characterSize, bold, chunkData.outlineThickness);
+			}
+		}
+	}
+}
+
+void sfv::TextLayout::layoutLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, GlyphShapeTable& shapes, std::vector<GlyphInstance>& instances, std::vector<GlyphInstance>& outlineInstances, std::vector<Segment>& segments, float* offsets) const
+{
+	placeLine(line, chunk, chunkStart, &shapes, &instances, &outlineInstances, &segments, offsets);
+}
+
+void sfv::TextLayout::boundLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, float* offsets) const
+{
+	placeLine(line, chunk, chunkStart, nullptr, nullptr, nullptr, nullptr, offsets);
+}
+
+void sfv::TextLayout::placeLine(Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart, GlyphShapeTable* shapes, std::vector<GlyphInstance>* instances, std::vector<GlyphInstance>* outlineInstances, std::vector<Segment>* segments, float* offsets) const
+{
+	line.instanceBegin = instances ? instances->size() : 0U;
+	line.outlineBegin = outlineInstances ? outlineInstances->size() : 0U;
+	line.segmentBegin = segments ? segments->size() : 0U;
+	line.minSize = std::numeric_limits<float>::max();
+	line.minX = std::numeric_limits<float>::max();
+	line.minY = std::numeric_limits<float>::max();
+	line.maxX = 0.f;
+	// The baseline of every line but the first one is reached through a newline
+	line.maxY = line.start != 0 ? line.y : 0.f;
+
+	const float y = line.y;
+	const std::size_t end = line.start + line.length;
+	float x = 0.f;
+	float previousX = 0.f;
+	sf::Uint32 prevChar = line.start != 0 ? m_string[line.start - 1] : 0U;
+	std::size_t offset = line.start;
+	TextStorage::const_iterator character = m_string.at(line.start);
+	for (; chunk != m_chunks.end() && offset < end; chunkStart += chunk->length, ++chunk) {
+		const Chunk& chunkData = m_chunks.getStyle(*chunk);
+		const std::size_t stop = std::min(end, chunkStart + chunk->length);
+		const std::size_t first = offset;
+		offset = stop;
+
+		// No font or text: nothing to draw, and the pen stays where it is
+		if (!chunkData.font || first == stop) {
+			if (offsets) {
+				std::fill(offsets + (first - line.start), offsets + (stop - line.start), x);
+			}
+			for (std::size_t i = first; i != stop; ++i) {
+				++character;
+			}
+			continue;
+		}
+		const std::size_t instanceCount = instances ? instances->size() : 0U;
+		const std::size_t outlineCount = outlineInstances ? outlineInstances->size() : 0U;
+
+		// Compute values related to the text style
+		const FontMetricsLookup glyphs(chunkData.font, m_missed);
+		const bool bold = (chunkData.style & sf::Text::Style::Bold) != 0;
+		const bool underlined = (chunkData.style & sf::Text::Style::Underlined) != 0;
+		const bool strikeThrough = (chunkData.style & sf::Text::Style::StrikeThrough) != 0;
+		const float italic = (chunkData.style & sf::Text::Style::Italic) ? 0.208f : 0.f; // 12 degrees
+		const float underlineOffset = glyphs.getUnderlinePosition(chunkData.characterSize);
+		const float underlineThickness = glyphs.getUnderlineThickness(chunkData.characterSize);
+
+		// Compute the location of the strike through dynamically
+		// We use the center point of the lowercase 'x' glyph as the reference
+		// We reuse the underline thickness as the thickness of the strike through as well
+		sf::FloatRect xBounds = glyphs.getGlyph(L'x', chunkData.characterSize, bold).bounds;
+		float strikeThroughOffset = xBounds.top + xBounds.height / 2.f;
+
+		// Precompute the variables needed by the algorithm
+		float hspace = static_cast<float>(glyphs.getGlyph(L' ', chunkData.characterSize, bold).advance);
+		line.minSize = std::min(line.minSize, static_cast<float>(chunkData.characterSize));
+
+		// Create one quad for each character
+		bool newline = false;
+		for (std::size_t i = first; i != stop; ++i, ++character)
+		{
+			sf::Uint32 curChar = *character;
+			if (offsets) {
+				offsets[i - line.start] = x;
+			}
+
+			// Apply the kerning offset
+			x += glyphs.getKerning(prevChar, curChar, chunkData.characterSize);
+			prevChar = curChar;
+
+			if (curChar == L'\n')
+			{
+				line.minX = std::min(line.minX, x);
+				line.minY = std::min(line.minY, y);
+
+				if (underlined) {
+					addLine(previousX, instances, shapes, x - previousX, y, chunkData.fillColor, underlineOffset, underlineThickness);
+
+					if (chunkData.outlineThickness != 0) {
+						addLine(previousX, outlineInstances, shapes, x - previousX, y, chunkData.outlineColor, underlineOffset, underlineThickness, chunkData.outlineThickness);
+					}
+				}
+				if (strikeThrough)
+				{
+					addLine(previousX, instances, shapes, x - previousX, y, chunkData.fillColor, strikeThroughOffset, underlineThickness);
+
+					if (chunkData.outlineThickness != 0) {
+						addLine(previousX, outlineInstances, shapes, x - previousX, y, chunkData.outlineColor, strikeThroughOffset, underlineThickness, chunkData.outlineThickness);
+					}
+				}
+				newline = true;
+				continue;
+			}
+			// Handle special characters
+			else if ((curChar == ' ') || (curChar == '\t'))
+			{
+				// Update the current bounds (min coordinates)
+				line.minX = std::min(line.minX, x);
+				line.minY = std::min(line.minY, y);
+
+				switch (curChar)
+				{
+				case ' ':  x += hspace;        break;
+				case '\t': x += hspace * 4;    break;
+				}
+
+				// Update the current bounds (max coordinates)
+				line.maxX = std::max(line.maxX, x);
+				line.maxY = std::max(line.maxY, y);
+
+				// Next glyph, no need to create a quad for whitespace
+				continue;
+			}
+
+
+			const sf::Glyph glyph = glyphs.getGlyph(curChar, chunkData.characterSize, bold);
+			// Offsets move the quad, the pen stays where it is
+			const sf::Vector2f position = m_glyphs.offsets ? sf::Vector2f(x, y) + m_glyphs.offsets[i] : sf::Vector2f(x, y);
+			if (chunkData.outlineThickness != 0)
+			{
+				const sf::Glyph glyph = glyphs.getGlyph(curChar, chunkData.characterSize, bold, chunkData.outlineThickness);
+				const float left = glyph.bounds.left;
+				const float top = glyph.bounds.top;
+				const float right = glyph.bounds.left + glyph.bounds.width;
+				const float bottom = glyph.bounds.top + glyph.bounds.height;
+				addGlyphQuad(outlineInstances, shapes, position, m_glyphs.outlineColors ? m_glyphs.outlineColors[i] : chunkData.outlineColor, glyph, italic, chunkData.outlineThickness);
+
+				// Update the current bounds with the outlined glyph bounds
+				line.minX = std::min(line.minX, position.x + left - italic * bottom - chunkData.outlineThickness);
+				line.maxX = std::max(line.maxX, position.x + right - italic * top - chunkData.outlineThickness);
+				line.minY = std::min(line.minY, position.y + top - chunkData.outlineThickness);
+				line.maxY = std::max(line.maxY, position.y + bottom - chunkData.outlineThickness);
+			}
+			else {
+				// Update the current bounds with the non outlined glyph bounds
+				const float left = glyph.bounds.left;
+				const float top = glyph.bounds.top;
+				const float right = glyph.bounds.left + glyph.bounds.width;
+				const float bottom = glyph.bounds.top + glyph.bounds.height;
+				line.minX = std::min(line.minX, position.x + left - italic * bottom);
+				line.maxX = std::max(line.maxX, position.x + right - italic * top);
+				line.minY = std::min(line.minY, position.y + top);
+				line.maxY = std::max(line.maxY, position.y + bottom);
+			}
+
+
+			addGlyphQuad(instances, shapes, position, m_glyphs.fillColors ? m_glyphs.fillColors[i] : chunkData.fillColor, glyph, italic);
+			// Advance to the next character
+			x += glyph.advance;
+		}
+		// If we're using the underlined style, add the last line
+		if (underlined && !newline && (x > 0))
+		{
+			addLine(previousX, instances, shapes, x - previousX, y, chunkData.fillColor, underlineOffset, underlineThickness);
+
+			if (chunkData.outlineThickness != 0)
+				addLine(previousX, outlineInstances, shapes, x - previousX, y, chunkData.outlineColor, underlineOffset, underlineThickness, chunkData.outlineThickness);
+		}
+
+		// If we're using the strike through style, add the last line across all characters
+		if (strikeThrough && !newline && (x > 0))
+		{
+			addLine(previousX, instances, shapes, x - previousX, y, chunkData.fillColor, strikeThroughOffset, underlineThickness);
+
+			if (chunkData.outlineThickness != 0)
+				addLine(previousX, outlineInstances, shapes, x - previousX, y, chunkData.outlineColor, strikeThroughOffset, underlineThickness, chunkData.outlineThickness);
+		}
+		if (segments) {
+			segments->push_back({ chunkData.font, nullptr, chunkData.characterSize, first - line.start, stop - first, instances->size() - instanceCount, outlineInstances->size() - outlineCount });
+		}
+		previousX = x;
+	}
+	line.advance = x;
+}
+
+void sfv::TextLayout::layoutLines(const std::vector<std::size_t>& starts, const Line* previous, WorkerPool* pool, GlyphShapeTable& shapes, std::vector<Line>& lines, std::vector<GlyphInstance>& instances, std::vector<GlyphInstance>& outlineInstances, std::vector<Segment>& segments, std::vector<Word>& words, std::vector<float>& offsets) const
+{
+	placeLines(starts, previous, pool, &shapes, lines, &instances, &outlineInstances, &segments, words, offsets);
+}
+
+void sfv::TextLayout::boundLines(const std::vector<std::size_t>& starts, const Line* previous, WorkerPool* pool, std::vector<Line>& lines, std::vector<Word>& words, std::vector<float>& offsets) const
+{
+	placeLines(starts, previous, pool, nullptr, lines, nullptr, nullptr, nullptr, words, offsets);
+}
+
+void sfv::TextLayout::placeLines(const std::vector<std::size_t>& starts, const Line* previous, WorkerPool* pool, GlyphShapeTable* shapes, std::vector<Line>& lines, std::vector<GlyphInstance>* instances, std::vector<GlyphInstance>* outlineInstances, std::vector<Segment>* segments, std::vector<Word>& words, std::vector<float>& offsets) const
+{
+	if (starts.empty()) {
+		return;
+	}
+	const std::size_t first = lines.size();
+	const std::size_t wordBase = words.size();
+
+	// Walk the runs of the paragraphs of [begin, end) along with them
+	const auto forEachParagraph = [this, &starts](std::size_t begin, std::size_t end, const auto& function) {
+		const auto location = m_chunks.find(starts[begin]);
+		auto chunk = m_chunks.at(location.index);
+		std::size_t chunkStart = location.start;
+		for (std::size_t index = begin; index != end; ++index) {
+			for (; chunk != m_chunks.end() && chunkStart + chunk->length <= starts[index]; ++chunk) {
+				chunkStart += chunk->length;
+			}
+			function(starts[index], chunk, chunkStart);
+		}
+	};
+	// Same for the lines of [begin, end)
+	const auto forEachLine = [this, &lines](std::size_t begin, std::size_t end, const auto& function) {
+		if (begin == end) {
+			return;
+		}
+		const auto location = m_chunks.find(lines[begin].start);
+		auto chunk = m_chunks.at(location.index);
+		std::size_t chunkStart = location.start;
+		for (std::size_t index = begin; index != end; ++index) {
+			Line& line = lines[index];
+			for (; chunk != m_chunks.end() && chunkStart + chunk->length <= line.start; ++chunk) {
+				chunkStart += chunk->length;
+			}
+			function(line, chunk, chunkStart);
+		}
+	};
+	// A baseline depends on every line above it, chaining them takes one addition per line.
+	// The pen positions of the characters of all the lines get their room at the same time.
+	const std::size_t offsetBase = offsets.size();
+	const auto chainBaselines = [&lines, first, previous, &offsets, offsetBase, &starts]() {
+		for (std::size_t index = first; index != lines.size(); ++index) {
+			lines[index].y = baseline(index != first ? &lines[index - 1] : previous, lines[index]);
+		}
+		offsets.resize(offsetBase + (lines.back().start + lines.back().length - starts.front()));
+	};
+
+	const auto placeSerially = [&]() {
+		forEachParagraph(0U, starts.size(), [&](std::size_t start, ChunkTree::const_iterator chunk, std::size_t chunkStart) {
+			measureParagraph(start, chunk, chunkStart, lines, words);
+		});
+		chainBaselines();
+		forEachLine(first, lines.size(), [&](Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart) {
+			placeLine(line, chunk, chunkStart, shapes, instances, outlineInstances, segments, offsets.data() + offsetBase + (line.start - starts.front()));
+		});
+	};
+	if (!pool || pool->getWorkerCount() == 1 || starts.back() - starts.front() < PARAGRAPH_TASK_LENGTH) {
+		placeSerially();
+		return;
+	}
+
+	std::vector<Paragraphs> tasks;
+	for (std::size_t begin = 0; begin != starts.size();) {
+		std::size_t end = begin + 1;
+		while (end != starts.size() && starts[end] - starts[begin] < PARAGRAPH_TASK_LENGTH) {
+			++end;
+		}
+		tasks.emplace_back();
+		tasks.back().begin = begin;
+		tasks.back().end = end;
+		begin = end;
+	}
+
+	// The workers share the glyph caches, so they only find metrics in them and never read a font.
+	// A miss means some metric was not warmed, and the calling thread lays the paragraphs out instead.
+	std::atomic<bool> missed(false);
+	const TextLayout shared(m_string, m_chunks, m_maxWidth, m_glyphs, &missed);
+	pool->run(tasks.size(), [&](std::size_t index) {
+		Paragraphs& task = tasks[index];
+		forEachParagraph(task.begin, task.end, [&shared, &task](std::size_t start, ChunkTree::const_iterator chunk, std::size_t chunkStart) {
+			shared.measureParagraph(start, chunk, chunkStart, task.lines, task.words);
+		});
+	});
+	if (missed.load()) {
+		placeSerially();
+		return;
+	}
+
+	for (auto& task : tasks) {
+		task.lineOffset = lines.size();
+		task.wordOffset = words.size();
+		for (auto& line : task.lines) {
+			line.wordBegin += task.wordOffset;
+		}
+		lines.insert(lines.end(), task.lines.begin(), task.lines.end());
+		words.insert(words.end(), task.words.begin(), task.words.end());
+	}
+	chainBaselines();
+
+	pool->run(tasks.size(), [&](std::size_t index) {
+		Paragraphs& task = tasks[index];
+		const bool quads = shapes != nullptr;
+		float* const paragraphOffsets = offsets.data() + offsetBase;
+		const std::size_t paragraphStart = starts.front();
+		forEachLine(task.lineOffset, task.lineOffset + task.lines.size(), [&shared, &task, quads, paragraphOffsets, paragraphStart](Line& line, ChunkTree::const_iterator chunk, std::size_t chunkStart) {
+			float* const lineOffsets = paragraphOffsets + (line.start - paragraphStart);
+			if (quads) {
+				shared.layoutLine(line, chunk, chunkStart, task.shapes, task.instances, task.outlineInstances, task.segments, lineOffsets);
+			}
+			else {
+				shared.boundLine(line, chunk, chunkStart, lineOffsets);
+			}
+		});
+	});
+	if (missed.load()) {
+		lines.resize(first);
+		words.resize(wordBase);
+		offsets.resize(offsetBase);
+		placeSerially();
+		return;
+	}
+	if (!shapes) {
+		return;
+	}
+
+	// Interning the shapes task after task hands out the indices a single pass would
+	std::size_t instanceCount = instances->size();
+	std::size_t outlineCount = outlineInstances->size();
+	std::size_t segmentCount = segments->size();
+	for (auto& task : tasks) {
+		task.remap.resize(task.shapes.size());
+		for (std::size_t shape = 0; shape != task.shapes.size(); ++shape) {
+			task.remap[shape] = shapes->intern(task.shapes[static_cast<sf::Uint32>(shape)]);
+		}
+		task.instanceOffset = instanceCount;
+		task.outlineOffset = outlineCount;
+		task.segmentOffset = segmentCount;
+		instanceCount += task.instances.size();
+		outlineCount += task.outlineInstances.size();
+		segmentCount += task.segments.size();
+	}
+	instances->resize(instanceCount);
+	outlineInstances->resize(outlineCount);
+	segments->resize(segmentCount);
+
+	pool->run(tasks.size(), [&](std::size_t index) {
+		const Paragraphs& task = tasks[index];
+		const auto copy = [&task](const std::vector<GlyphInstance>& source, std::vector<GlyphInstance>& target, std::size_t offset) {
+			for (std::size_t instance = 0; instance != source.size(); ++instance) {
+				target[offset + instance] = source[instance];
+				target[offset + instance].shape = task.remap[source[instance].shape];
+			}
+		};
+		copy(task.instances, *instances, task.instanceOffset);
+		copy(task.outlineInstances, *outlineInstances, task.outlineOffset);
+		std::copy(task.segments.begin(), task.segments.end(), segments->begin() + task.segmentOffset);
+		for (std::size_t line = task.lineOffset; line != task.lineOffset + task.lines.size(); ++line) {
+			lines[line].instanceBegin += task.instanceOffset;
+			lines[line].outlineBegin += task.outlineOffset;
+			lines[line].segmentBegin += task.segmentOffset;
+		}
+	});
+}
+
+sf::Vector2f sfv::TextLayout::findCharacterPos(const std::vector<Line>& lines, const std::vector<float>& offsets, std::size_t subIndex) const
+{
+	if (lines.empty()) {
+		return sf::Vector2f();
+	}
+	subIndex = std::min(subIndex, m_string.getSize());
+
+	const auto line = std::upper_bound(lines.begin(), lines.end(), subIndex, [](std::size_t index, const Line& line) {
+		return index < line.start;
+	}) - 1;
+	// Only the end of the string is past the last character of its line
+	const float x = subIndex < line->start + line->length ? offsets[subIndex] : line->advance;
+	return sf::Vector2f(x, line->y - static_cast<float>(line->characterSize));
+}
+
+sfv::TextLayout::Hit sfv::TextLayout::findCharacter(const std::vector<Line>& lines, const std::vector<float>& offsets, sf::Vector2f point) const
+{
+	if (lines.empty()) {
+		return { 0U, 0U, false };
+	}
+	// Lines reach from the top of their characters down to the next line
+	auto line = std::upper_bound(lines.begin(), lines.end(), point.y, [](float y, const Line& line) {
+		return y < line.y - static_cast<float>(line.characterSize);
+	});
+	line = line != lines.begin() ? line - 1 : line;
+	const Hit lineHit{ line->start, static_cast<std::size_t>(line - lines.begin()), false };
+
+	std::size_t end = line->start + line->length;
+	if (end != line->start && m_string[end - 1] == L'\n') {
+		--end;
+	}
+	if (end == line->start) {
+		return lineHit;
+	}
+	// A character spans from its pen position to the one of the character after it
+	const auto first = offsets.begin() + line->start;
+	const auto last = offsets.begin() + end;
+	const auto after = std::upper_bound(first, last, point.x);
+	if (after == first) {
+		return lineHit;
+	}
+	const std::size_t index = static_cast<std::size_t>(after - offsets.begin()) - 1;
+	const float right = index + 1 < line->start + line->length ? offsets[index + 1] : line->advance;
+	return { index, lineHit.line, point.x >= (offsets[index] + right) / 2.f };
+}
+
+float sfv::TextLayout::lineAdvance(float previousHeight, float height)
+{
+	const float max = std::max(height, previousHeight);
+	return std::round(height * 0.65f + max * 0.25f + previousHeight * 0.1f);
+}
+
+float sfv::TextLayout::baseline(const Line* previous, const Line& line)
+{
+	return previous ? previous->y + lineAdvance(previous->height, line.height) : static_cast<float>(line.characterSize);
+}
+
+sf::FloatRect sfv::TextLayout::getBounds(const std::vector<Line>& lines)
+{
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = 0.f;
+	float maxY = 0.f;
+	for (const auto& line : lines) {
+		minX = std::min({ minX, line.minX, line.minSize });
+		minY = std::min({ minY, line.minY, line.minSize });
+		maxX = std::max(maxX, line.maxX);
+		maxY = std::max(maxY, line.maxY);
+	}
+	return sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
@@ -0,0 +1,554 @@
+#include "TextStorage.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	const sf::Uint32 REPLACEMENT = 0xFFFD;
+
+	// Bytes of the UTF-8 sequence starting with lead, which the storage wrote itself
+	std::size_t sequenceLength(unsigned char lead)
+	{
+		return lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+	}
+
+	bool isTrailing(unsigned char byte)
+	{
+		return (byte & 0xC0) == 0x80;
+	}
+
+	std::size_t encodedLength(sf::Uint32 character)
+	{
+		return character < 0x80 ? 1 : character < 0x800 ? 2 : character < 0x10000 ? 3 : 4;
+	}
+
+	// Surrogates are written like any other character so every UTF-32 string comes back unchanged,
+	// only values past what four bytes hold become U+FFFD
+	void encode(sf::Uint32 character, char* bytes)
+	{
+		if (character > 0x1FFFFF) {
+			character = REPLACEMENT;
+		}
+		if (character < 0x80) {
+			bytes[0] = static_cast<char>(character);
+		}
+		else if (character < 0x800) {
+			bytes[0] = static_cast<char>(0xC0 | (character >> 6));
+			bytes[1] = static_cast<char>(0x80 | (character & 0x3F));
+		}
+		else if (character < 0x10000) {
+			bytes[0] = static_cast<char>(0xE0 | (character >> 12));
+			bytes[1] = static_cast<char>(0x80 | ((character >> 6) & 0x3F));
+			bytes[2] = static_cast<char>(0x80 | (character & 0x3F));
+		}
+		else {
+			bytes[0] = static_cast<char>(0xF0 | (character >> 18));
+			bytes[1] = static_cast<char>(0x80 | ((character >> 12) & 0x3F));
+			bytes[2] = static_cast<char>(0x80 | ((character >> 6) & 0x3F));
+			bytes[3] = static_cast<char>(0x80 | (character & 0x3F));
+		}
+	}
+
+	sf::Uint32 decode(const char* bytes)
+	{
+		const sf::Uint32 lead = static_cast<unsigned char>(bytes[0]);
+		const auto trail = [bytes](std::size_t index) {
+			return static_cast<sf::Uint32>(static_cast<unsigned char>(bytes[index]) & 0x3F);
+		};
+		if (lead < 0x80) {
+			return lead;
+		}
+		if (lead < 0xE0) {
+			return ((lead & 0x1F) << 6) | trail(1);
+		}
+		if (lead < 0xF0) {
+			return ((lead & 0x0F) << 12) | (trail(1) << 6) | trail(2);
+		}
+		return ((lead & 0x07) << 18) | (trail(1) << 12) | (trail(2) << 6) | trail(3);
+	}
+
+	// Decode one character of UTF-8 from outside and move past it
+	sf::Uint32 decodeUtf8(std::string_view::const_iterator& begin, std::string_view::const_iterator end)
+	{
+		const sf::Uint32 lead = static_cast<unsigned char>(*begin++);
+		if (lead < 0x80) {
+			return lead;
+		}
+		std::size_t trailing;
+		sf::Uint32 character;
+		sf::Uint32 minimum;
+		if ((lead & 0xE0) == 0xC0) {
+			trailing = 1;
+			character = lead & 0x1F;
+			minimum = 0x80;
+		}
+		else if ((lead & 0xF0) == 0xE0) {
+			trailing = 2;
+			character = lead & 0x0F;
+			minimum = 0x800;
+		}
+		else if ((lead & 0xF8) == 0xF0) {
+			trailing = 3;
+			character = lead & 0x07;
+			minimum = 0x10000;
+		}
+		else {
+			return REPLACEMENT;
+		}
+		for (; trailing != 0; --trailing) {
+			if (begin == end || (static_cast<unsigned char>(*begin) & 0xC0) != 0x80) {
+				return REPLACEMENT;
+			}
+			character = (character << 6) | (static_cast<unsigned char>(*begin++) & 0x3F);
+		}
+		// Overlong forms, surrogates and code points past Unicode are not characters
+		if (character < minimum || character > 0x10FFFF || (character >= 0xD800 && character <= 0xDFFF)) {
+			return REPLACEMENT;
+		}
+		return character;
+	}
+
+	// Write the characters next reads from [begin, end) over those of string, growing it only past its size
+	template <typename Iterator, typename Next>
+	void overwrite(sf::String& string, Iterator begin, Iterator end, Next next)
+	{
+		const std::size_t held = string.getSize();
+		std::size_t size = 0;
+		while (begin != end) {
+			const sf::Uint32 character = next(begin, end);
+			if (size < held) {
+				string[size] = character;
+			}
+			else {
+				// A single character fits in the string itself, so only growing the storage allocates
+				string += sf::String(character);
+			}
+			++size;
+		}
+		if (size < held) {
+			string.erase(size, held - size);
+		}
+	}
+}
+
+sfv::TextStorage::const_iterator::const_iterator(const TextStorage* storage, std::size_t index, std::size_t byte)
+	: m_storage(storage),
+	m_index(index),
+	m_byte(byte)
+{
+}
+
+sf::Uint32 sfv::TextStorage::const_iterator::operator*() const
+{
+	switch (m_storage->m_encoding) {
+	case Latin1:
+		return static_cast<unsigned char>(m_storage->m_bytes[m_byte]);
+	case Utf8:
+		return decode(m_storage->m_bytes.data() + m_byte);
+	default:
+		return m_storage->m_string[m_index];
+	}
+}
+
+sfv::TextStorage::const_iterator& sfv::TextStorage::const_iterator::operator++()
+{
+	if (m_storage->m_encoding == Utf8) {
+		m_byte += sequenceLength(static_cast<unsigned char>(m_storage->m_bytes[m_byte]));
+	}
+	else {
+		++m_byte;
+	}
+	++m_index;
+	return *this;
+}
+
+std::size_t sfv::TextStorage::const_iterator::getIndex() const
+{
+	return m_index;
+}
+
+bool sfv::TextStorage::const_iterator::operator==(const const_iterator& other) const
+{
+	return m_index == other.m_index;
+}
+
+bool sfv::TextStorage::const_iterator::operator!=(const const_iterator& other) const
+{
+	return m_index != other.m_index;
+}
+
+sfv::TextStorage::TextStorage()
+	: m_encoding(Utf32),
+	m_stale(false),
+	m_size(0)
+{
+}
+
+sfv::TextStorage::TextStorage(const sf::String& string)
+	: m_encoding(Utf32),
+	m_string(string),
+	m_stale(false),
+	m_size(0)
+{
+}
+
+void sfv::TextStorage::setCompact(bool compact)
+{
+	if (compact == isCompact()) {
+		return;
+	}
+	if (compact) {
+		reset();
+		for (const sf::Uint32 character : m_string) {
+			push(character);
+		}
+		m_string = sf::String();
+		return;
+	}
+	toString();
+	m_encoding = Utf32;
+	m_stale = false;
+	m_bytes = std::string();
+	m_checkpoints = std::vector<Checkpoint>();
+	m_size = 0;
+}
+
+bool sfv::TextStorage::isCompact() const
+{
+	return m_encoding != Utf32;
+}
+
+sfv::TextStorage::Encoding sfv::TextStorage::getEncoding() const
+{
+	return m_encoding;
+}
+
+std::size_t sfv::TextStorage::getByteSize() const
+{
+	if (!isCompact()) {
+		return m_string.getSize() * sizeof(sf::Uint32);
+	}
+	return m_bytes.size() + m_checkpoints.size() * sizeof(Checkpoint);
+}
+
+std::size_t sfv::TextStorage::getSize() const
+{
+	return isCompact() ? m_size : m_string.getSize();
+}
+
+bool sfv::TextStorage::isEmpty() const
+{
+	return getSize() == 0;
+}
+
+sf::Uint32 sfv::TextStorage::operator[](std::size_t index) const
+{
+	switch (m_encoding) {
+	case Latin1:
+		return static_cast<unsigned char>(m_bytes[index]);
+	case Utf8:
+		return decode(m_bytes.data() + byteOffset(index));
+	default:
+		return m_string[index];
+	}
+}
+
+std::size_t sfv::TextStorage::find(sf::Uint32 character, std::size_t start, std::size_t end) const
+{
+	end = std::min(end, getSize());
+	if (start >= end) {
+		return end;
+	}
+	switch (m_encoding) {
+	case Latin1: {
+		if (character > 0xFF) {
+			return end;
+		}
+		const void* found = std::memchr(m_bytes.data() + start, static_cast<int>(character), end - start);
+		return found ? static_cast<std::size_t>(static_cast<const char*>(found) - m_bytes.data()) : end;
+	}
+	case Utf8: {
+		// A character of one byte never shows up inside a longer sequence, so bytes are compared as they are
+		std::size_t byte = byteOffset(start);
+		for (std::size_t index = start; index != end; ++index) {
+			const unsigned char lead = static_cast<unsigned char>(m_bytes[byte]);
+			if (character < 0x80 ? lead == character : decode(m_bytes.data() + byte) == character) {
+				return index;
+			}
+			byte += sequenceLength(lead);
+		}
+		return end;
+	}
+	default:
+		return static_cast<std::size_t>(std::find(m_string.begin() + start, m_string.begin() + end, character) - m_string.begin());
+	}
+}
+
+sfv::TextStorage::const_iterator sfv::TextStorage::begin() const
+{
+	return const_iterator(this, 0U, 0U);
+}
+
+sfv::TextStorage::const_iterator sfv::TextStorage::end() const
+{
+	return const_iterator(this, getSize(), isCompact() ? m_bytes.size() : 0U);
+}
+
+sfv::TextStorage::const_iterator sfv::TextStorage::at(std::size_t index) const
+{
+	return const_iterator(this, index, isCompact() ? byteOffset(index) : 0U);
+}
+
+const sf::String& sfv::TextStorage::toString() const
+{
+	if (m_stale) {
+		overwrite(m_string, begin(), end(), [](const_iterator& begin, const_iterator) {
+			const sf::Uint32 character = *begin;
+			++begin;
+			return character;
+		});
+		m_stale = false;
+	}
+	return m_string;
+}
+
+void sfv::TextStorage::assign(const sf::String& string)
+{
+	if (!isCompact()) {
+		// Copies keep the storage of the string when the text fits in it
+		m_string = string;
+		return;
+	}
+	reset();
+	dropString();
+	for (const sf::Uint32 character : string) {
+		push(character);
+	}
+}
+
+void sfv::TextStorage::assign(sf::String&& string)
+{
+	if (!isCompact()) {
+		m_string = std::move(string);
+		return;
+	}
+	assign(static_cast<const sf::String&>(string));
+}
+
+void sfv::TextStorage::assign(std::u32string_view string)
+{
+	if (!isCompact()) {
+		overwrite(m_string, string.begin(), string.end(), [](std::u32string_view::const_iterator& begin, std::u32string_view::const_iterator) {
+			return static_cast<sf::Uint32>(*begin++);
+		});
+		return;
+	}
+	reset();
+	dropString();
+	for (const char32_t character : string) {
+		push(static_cast<sf::Uint32>(character));
+	}
+}
+
+void sfv::TextStorage::assign(std::string_view utf8)
+{
+	if (!isCompact()) {
+		overwrite(m_string, utf8.begin(), utf8.end(), decodeUtf8);
+		return;
+	}
+	reset();
+	dropString();
+	for (auto byte = utf8.begin(); byte != utf8.end();) {
+		push(decodeUtf8(byte, utf8.end()));
+	}
+}
+
+void sfv::TextStorage::insert(std::size_t index, const sf::String& string)
+{
+	if (!isCompact()) {
+		m_string.insert(index, string);
+		return;
+	}
+	if (string.isEmpty()) {
+		return;
+	}
+	if (m_encoding == Latin1 && std::any_of(string.begin(), string.end(), [](sf::Uint32 character) { return character > 0xFF; })) {
+		widen();
+	}
+	if (m_encoding == Latin1) {
+		m_bytes.insert(index, string.getSize(), '\0');
+		std::transform(string.begin(), string.end(), m_bytes.begin() + index, [](sf::Uint32 character) {
+			return static_cast<char>(character);
+		});
+	}
+	else {
+		std::size_t length = 0;
+		for (const sf::Uint32 character : string) {
+			length += encodedLength(character);
+		}
+		std::size_t byte = byteOffset(index);
+		m_bytes.insert(byte, length, '\0');
+		for (const sf::Uint32 character : string) {
+			encode(character, &m_bytes[byte]);
+			byte += encodedLength(character);
+		}
+		m_size += string.getSize();
+		reindex(index, 0U, static_cast<std::ptrdiff_t>(string.getSize()), static_cast<std::ptrdiff_t>(length));
+		dropString();
+		return;
+	}
+	m_size += string.getSize();
+	dropString();
+}
+
+void sfv::TextStorage::erase(std::size_t index, std::size_t count)
+{
+	index = std::min(index, getSize());
+	count = std::min(count, getSize() - index);
+	if (!isCompact()) {
+		m_string.erase(index, count);
+		return;
+	}
+	if (count == 0) {
+		return;
+	}
+	const std::size_t first = byteOffset(index);
+	const std::size_t length = byteOffset(index + count) - first;
+	m_bytes.erase(first, length);
+	m_size -= count;
+	if (m_encoding == Utf8) {
+		reindex(index, count, -static_cast<std::ptrdiff_t>(count), -static_cast<std::ptrdiff_t>(length));
+	}
+	dropString();
+}
+
+std::size_t sfv::TextStorage::byteOffset(std::size_t index) const
+{
+	if (m_encoding != Utf8) {
+		return index;
+	}
+	if (index >= m_size) {
+		return m_bytes.size();
+	}
+	const auto checkpoint = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), index, [](std::size_t index, const Checkpoint& checkpoint) {
+		return index < checkpoint.character;
+	}) - 1;
+	return skip(checkpoint->byte, index - checkpoint->character);
+}
+
+void sfv::TextStorage::reset()
+{
+	m_encoding = Latin1;
+	m_bytes.clear();
+	m_checkpoints.clear();
+	m_size = 0;
+	m_stale = true;
+}
+
+void sfv::TextStorage::dropString()
+{
+	m_string = sf::String();
+	m_stale = true;
+}
+
+void sfv::TextStorage::push(sf::Uint32 character)
+{
+	if (m_encoding == Latin1 && character > 0xFF) {
+		widen();
+	}
+	if (m_encoding == Latin1) {
+		m_bytes.push_back(static_cast<char>(character));
+	}
+	else {
+		if (m_size % STRIDE == 0) {
+			m_checkpoints.push_back({ m_size, m_bytes.size() });
+		}
+		char bytes[4];
+		encode(character, bytes);
+		m_bytes.append(bytes, encodedLength(character));
+	}
+	++m_size;
+}
+
+void sfv::TextStorage::widen()
+{
+	// Characters past 0x7F take two bytes, so everything is moved back to front in place
+	const std::size_t size = m_bytes.size();
+	const std::size_t wide = static_cast<std::size_t>(std::count_if(m_bytes.begin(), m_bytes.end(), [](char byte) {
+		return static_cast<unsigned char>(byte) >= 0x80;
+	}));
+	m_bytes.resize(size + wide);
+	std::size_t write = m_bytes.size();
+	for (std::size_t read = size; read != 0;) {
+		const unsigned char character = static_cast<unsigned char>(m_bytes[--read]);
+		if (character < 0x80) {
+			m_bytes[--write] = static_cast<char>(character);
+		}
+		else {
+			m_bytes[--write] = static_cast<char>(0x80 | (character & 0x3F));
+			m_bytes[--write] = static_cast<char>(0xC0 | (character >> 6));
+		}
+	}
+	m_encoding = Utf8;
+	m_checkpoints.clear();
+	reindex(0U, 0U, 0, 0);
+}
+
+void sfv::TextStorage::reindex(std::size_t index, std::size_t count, std::ptrdiff_t characters, std::ptrdiff_t bytes)
+{
+	const auto after = [](std::size_t index, const Checkpoint& checkpoint) {
+		return index < checkpoint.character;
+	};
+	// Checkpoints up to index stay, those in the replaced characters go and those past them move
+	const std::size_t first = static_cast<std::size_t>(std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), index, after) - m_checkpoints.begin());
+	const std::size_t last = static_cast<std::size_t>(std::upper_bound(m_checkpoints.begin() + first, m_checkpoints.end(), index + count, after) - m_checkpoints.begin());
+	for (std::size_t moved = last; moved != m_checkpoints.size(); ++moved) {
+		m_checkpoints[moved].character += characters;
+		m_checkpoints[moved].byte += bytes;
+	}
+
+	// Fill the gap between the checkpoints around the edit, the first character always has one
+	Checkpoint next = first != 0 ? m_checkpoints[first - 1] : Checkpoint{ 0U, 0U };
+	const std::size_t start = first != 0 ? next.character + STRIDE : 0U;
+	const std::size_t until = last != m_checkpoints.size() ? m_checkpoints[last].character : m_size;
+	const std::size_t added = start < until ? (until - start - 1) / STRIDE + 1 : 0U;
+	if (added > last - first) {
+		m_checkpoints.insert(m_checkpoints.begin() + last, added - (last - first), Checkpoint());
+	}
+	else {
+		m_checkpoints.erase(m_checkpoints.begin() + first + added, m_checkpoints.begin() + last);
+	}
+	for (std::size_t checkpoint = first; checkpoint != first + added; ++checkpoint) {
+		if (checkpoint != 0) {
+			next.byte = skip(next.byte, STRIDE);
+			next.character += STRIDE;
+		}
+		m_checkpoints[checkpoint] = next;
+	}
+}
+
+std::size_t sfv::TextStorage::skip(std::size_t byte, std::size_t count) const
+{
+	// Whole words are passed while they hold no more characters than are left to skip
+	const std::uint64_t HIGH_BITS = 0x8080808080808080ULL;
+	while (byte + sizeof(std::uint64_t) <= m_bytes.size()) {
+		std::uint64_t word;
+		std::memcpy(&word, m_bytes.data() + byte, sizeof(word));
+		const std::uint64_t trailing = (word & ~(word << 1) & HIGH_BITS) >> 7;
+		const std::size_t characters = sizeof(word) - static_cast<std::size_t>((trailing * 0x0101010101010101ULL) >> 56);
+		if (characters > count) {
+			break;
+		}
+		count -= characters;
+		byte += sizeof(word);
+	}
+	for (;; ++byte) {
+		if (!isTrailing(static_cast<unsigned char>(m_bytes[byte]))) {
+			if (count == 0) {
+				return byte;
+			}
+			--count;
+		}
+	}
+}
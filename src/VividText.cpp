@@ -1,63 +1,262 @@
 #include "VividText.h"
+#include "GlyphCache.h"
+#include "MarkupParser.h"
 #include <SFML/Graphics/RenderTarget.hpp>
-#include <cmath>
+#include <algorithm>
+#include <limits>
+#ifdef SFV_STATISTICS
+#include <atomic>
+#include <chrono>
+#endif
 
 ////////////////////////////////////////////////////////////
 // Source Author: Laurent Gomila
 // Taken from SFML-2.4.1 Text.cpp
 // Edits made to the source:
-//    -Modified addLine & addGlyphQuad to work with std::vector<sf::Vertex>
-//    -Modified ensureGeometryUpdate to work with varying styles, fonts, and sizes.
+//    -Modified ensureGeometryUpdate to relayout only the lines touched by an edit, see TextLayout
 ////////////////////////////////////////////////////////////
 namespace
 {
-	// Add an underline or strikethrough line to the vertex array
-	void addLine(float xOffset, std::vector<sf::Vertex>& vertices, float lineLength, float lineTop, const sf::Color& color, float offset, float thickness, float outlineThickness = 0)
+	// Replace the elements in [begin, end) of target with the content of source
+	template <typename T>
+	void splice(std::vector<T>& target, std::size_t begin, std::size_t end, const std::vector<T>& source)
 	{
-		const sf::Vector2f texCoords(1.f, 1.f);
-		float top = std::roundf(lineTop + offset - (thickness / 2) + 0.5f);
-		float bottom = top + std::floor(thickness + 0.5f);
+		const std::size_t replaced = end - begin;
+		if (source.size() > replaced) {
+			target.insert(target.begin() + end, source.size() - replaced, T());
+		}
+		else {
+			target.erase(target.begin() + begin + source.size(), target.begin() + end);
+		}
+		std::copy(source.begin(), source.end(), target.begin() + begin);
+	}
 
-		vertices.emplace_back(sf::Vector2f(-outlineThickness + xOffset, top - outlineThickness), color, texCoords);
-		vertices.emplace_back(sf::Vector2f(lineLength + outlineThickness + xOffset, top - outlineThickness), color, texCoords);
-		vertices.emplace_back(sf::Vector2f(-outlineThickness + xOffset, bottom + outlineThickness), color, texCoords);
-		vertices.emplace_back(sf::Vector2f(-outlineThickness + xOffset, bottom + outlineThickness), color, texCoords);
-		vertices.emplace_back(sf::Vector2f(lineLength + outlineThickness + xOffset, top - outlineThickness), color, texCoords);
-		vertices.emplace_back(sf::Vector2f(lineLength + outlineThickness + xOffset, bottom + outlineThickness), color, texCoords);
+	const std::size_t NULL_INDEX = static_cast<std::size_t>(-1);
+
+	// Edits laying out fewer characters than this stay on the calling thread
+	const std::size_t PARALLEL_LAYOUT_LENGTH = 16384;
+
+	// Triangles are only needed while a batch is submitted, so every text shares one buffer
+	std::vector<sf::Vertex>& expansionBuffer()
+	{
+		thread_local std::vector<sf::Vertex> vertices;
+		return vertices;
 	}
 
-	// Add a glyph quad to the vertex array
-	void addGlyphQuad(std::vector<sf::Vertex>& vertices, sf::Vector2f position, const sf::Color& color, const sf::Glyph& glyph, float italic, float outlineThickness = 0)
+	// Append a run, growing the last one instead when they share their style
+	void appendRun(std::vector<sfv::ChunkTree::Run>& runs, const sfv::ChunkTree::Run& chunk)
 	{
-		const float left = glyph.bounds.left;
-		const float top = glyph.bounds.top;
-		const float right = glyph.bounds.left + glyph.bounds.width;
-		const float bottom = glyph.bounds.top + glyph.bounds.height;
-
-		const float u1 = static_cast<float>(glyph.textureRect.left);
-		const float v1 = static_cast<float>(glyph.textureRect.top);
-		const float u2 = static_cast<float>(glyph.textureRect.left + glyph.textureRect.width);
-		const float v2 = static_cast<float>(glyph.textureRect.top + glyph.textureRect.height);
-		vertices.emplace_back(sf::Vector2f(position.x + left - italic * top - outlineThickness, position.y + top - outlineThickness), color, sf::Vector2f(u1, v1));
-		vertices.emplace_back(sf::Vector2f(position.x + right - italic * top - outlineThickness, position.y + top - outlineThickness), color, sf::Vector2f(u2, v1));
-		vertices.emplace_back(sf::Vector2f(position.x + left - italic * bottom - outlineThickness, position.y + bottom - outlineThickness), color, sf::Vector2f(u1, v2));
-		vertices.emplace_back(sf::Vector2f(position.x + left - italic * bottom - outlineThickness, position.y + bottom - outlineThickness), color, sf::Vector2f(u1, v2));
-		vertices.emplace_back(sf::Vector2f(position.x + right - italic * top - outlineThickness, position.y + top - outlineThickness), color, sf::Vector2f(u2, v1));
-		vertices.emplace_back(sf::Vector2f(position.x + right - italic * bottom - outlineThickness, position.y + bottom - outlineThickness), color, sf::Vector2f(u2, v2));
+		if (!runs.empty() && runs.back().style == chunk.style) {
+			runs.back().length += chunk.length;
+		}
+		else {
+			runs.push_back(chunk);
+		}
 	}
 
-	const std::size_t NULL_INDEX = static_cast<std::size_t>(-1);
+	// Lines laid out by a pass before they are spliced into the text, the buffers of one thread serve every text
+	struct LayoutBuffers {
+		std::vector<std::size_t> starts;
+		std::vector<sfv::TextLayout::Line> lines;
+		std::vector<sfv::GlyphInstance> instances;
+		std::vector<sfv::GlyphInstance> outlineInstances;
+		std::vector<sfv::TextLayout::Segment> segments;
+		std::vector<sfv::TextLayout::Word> words;
+		std::vector<float> offsets;
+	};
+
+	LayoutBuffers& layoutBuffers()
+	{
+		thread_local LayoutBuffers buffers;
+		buffers.starts.clear();
+		buffers.lines.clear();
+		buffers.instances.clear();
+		buffers.outlineInstances.clear();
+		buffers.segments.clear();
+		buffers.words.clear();
+		buffers.offsets.clear();
+		return buffers;
+	}
+
+	// Parsed runs are copied into the tree, so the buffers of one parser serve every text
+	sfv::MarkupParser& markupParser()
+	{
+		thread_local sfv::MarkupParser parser;
+		return parser;
+	}
+
+#ifdef SFV_STATISTICS
+	typedef std::chrono::steady_clock Clock;
+	typedef std::size_t sfv::TextStatistics::* Counter;
+
+	const Counter COUNTERS[] = {
+		&sfv::TextStatistics::layouts,
+		&sfv::TextStatistics::rewraps,
+		&sfv::TextStatistics::windowLayouts,
+		&sfv::TextStatistics::layoutNanoseconds,
+		&sfv::TextStatistics::glyphLookups,
+		&sfv::TextStatistics::kerningLookups,
+		&sfv::TextStatistics::quads,
+		&sfv::TextStatistics::vertices,
+		&sfv::TextStatistics::chunkSplits,
+		&sfv::TextStatistics::chunkMerges,
+		&sfv::TextStatistics::instanceReallocations,
+		&sfv::TextStatistics::chunkReallocations,
+		&sfv::TextStatistics::draws,
+		&sfv::TextStatistics::drawCalls
+	};
+	const std::size_t COUNTER_COUNT = sizeof(COUNTERS) / sizeof(COUNTERS[0]);
+
+	// Counters of every text, the workers of prepare add to them too
+	std::atomic<std::size_t> totals[COUNTER_COUNT];
+
+	sfv::ProfilerHooks profilerHooks = { nullptr, nullptr };
+
+	void addStatistic(sfv::TextStatistics& statistics, Counter counter, std::size_t amount)
+	{
+		statistics.*counter += amount;
+		for (std::size_t index = 0; index != COUNTER_COUNT; ++index) {
+			if (COUNTERS[index] == counter) {
+				totals[index].fetch_add(amount, std::memory_order_relaxed);
+				return;
+			}
+		}
+	}
+
+	// Reports a zone to the profiler while it lives
+	class ProfileZone {
+	private:
+		void* m_handle;
+	public:
+		explicit ProfileZone(const char* zone)
+			: m_handle(profilerHooks.begin ? profilerHooks.begin(zone) : nullptr)
+		{
+		}
+
+		~ProfileZone()
+		{
+			if (profilerHooks.end) {
+				profilerHooks.end(m_handle);
+			}
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+	};
+
+	// Counts a layout pass, the time it takes and the glyph cache lookups it makes
+	class PassCounter {
+	private:
+		ProfileZone m_zone;
+		sfv::TextStatistics& m_statistics;
+		Clock::time_point m_start;
+		sfv::GlyphCache::Statistics m_cache;
+	public:
+		PassCounter(sfv::TextStatistics& statistics, Counter pass, const char* zone)
+			: m_zone(zone),
+			m_statistics(statistics),
+			m_start(Clock::now()),
+			m_cache(sfv::GlyphCache::getTotalStatistics())
+		{
+			addStatistic(m_statistics, pass, 1U);
+		}
+
+		~PassCounter()
+		{
+			// Lookups on workers count nothing, and the caches may have been reset meanwhile
+			const sfv::GlyphCache::Statistics cache = sfv::GlyphCache::getTotalStatistics();
+			const std::size_t glyphs = cache.glyphHits + cache.glyphMisses;
+			const std::size_t kernings = cache.kerningHits + cache.kerningMisses;
+			addStatistic(m_statistics, &sfv::TextStatistics::glyphLookups, glyphs - std::min(glyphs, m_cache.glyphHits + m_cache.glyphMisses));
+			addStatistic(m_statistics, &sfv::TextStatistics::kerningLookups, kernings - std::min(kernings, m_cache.kerningHits + m_cache.kerningMisses));
+			addStatistic(m_statistics, &sfv::TextStatistics::layoutNanoseconds, static_cast<std::size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count()));
+		}
+
+		PassCounter(const PassCounter&) = delete;
+		PassCounter& operator=(const PassCounter&) = delete;
+	};
+#endif
 }
+
+#ifdef SFV_STATISTICS
+#define SFV_COUNT(counter, amount) addStatistic(m_statistics, &sfv::TextStatistics::counter, amount)
+#define SFV_PASS(pass, zone) const PassCounter passCounter(m_statistics, &sfv::TextStatistics::pass, zone)
+#define SFV_ZONE(zone) const ProfileZone profileZone(zone)
+#else
+#define SFV_COUNT(counter, amount)
+#define SFV_PASS(pass, zone)
+#define SFV_ZONE(zone)
+#endif
+
 sfv::VividText::VividText(const sf::String& text, const sf::Font& font)
-	: m_font(&font),
-	m_vertices(sf::PrimitiveType::Triangles)
+	: m_needsUpdate(false),
+	m_needsRewrap(false),
+	m_revision(0),
+	m_dirtyStart(0),
+	m_dirtyEnd(0),
+	m_dirtyDelta(0),
+	m_font(&font),
+	m_atlas(nullptr),
+	m_sink(nullptr),
+	m_pool(nullptr),
+	m_cache(nullptr),
+	m_maxWidth(0.f),
+	m_viewport(),
+	m_followView(false),
+	m_windowBegin(0),
+	m_windowEnd(0),
+	m_windowTop(std::numeric_limits<float>::max()),
+	m_windowBottom(std::numeric_limits<float>::lowest()),
+	m_changedBegin{ NULL_INDEX, NULL_INDEX },
+	m_changedEnd{ 0U, 0U },
+	m_unresolvedBegin(0),
+	m_unresolvedEnd(0),
+	m_editDepth(0),
+	m_paintedEdits(0),
+	m_scrollback(0),
+	m_lineCount(0)
 {
+#ifdef SFV_STATISTICS
+	m_statistics = TextStatistics();
+	m_instanceCapacity = 0U;
+	m_chunkCapacity = m_chunks.capacity();
+#endif
 	setString(text);
 }
 
 sfv::VividText::VividText()
+	: m_needsUpdate(false),
+	m_needsRewrap(false),
+	m_revision(0),
+	m_dirtyStart(0),
+	m_dirtyEnd(0),
+	m_dirtyDelta(0),
+	m_font(nullptr),
+	m_atlas(nullptr),
+	m_sink(nullptr),
+	m_pool(nullptr),
+	m_cache(nullptr),
+	m_maxWidth(0.f),
+	m_viewport(),
+	m_followView(false),
+	m_windowBegin(0),
+	m_windowEnd(0),
+	m_windowTop(std::numeric_limits<float>::max()),
+	m_windowBottom(std::numeric_limits<float>::lowest()),
+	m_changedBegin{ NULL_INDEX, NULL_INDEX },
+	m_changedEnd{ 0U, 0U },
+	m_unresolvedBegin(0),
+	m_unresolvedEnd(0),
+	m_editDepth(0),
+	m_paintedEdits(0),
+	m_scrollback(0),
+	m_lineCount(0)
 {
-
+#ifdef SFV_STATISTICS
+	m_statistics = TextStatistics();
+	m_instanceCapacity = 0U;
+	m_chunkCapacity = m_chunks.capacity();
+#endif
 }
 
 sfv::VividText::~VividText()
@@ -113,7 +312,7 @@ void sfv::VividText::setOutlineColor(sf::Color color, std::size_t start)
 void sfv::VividText::setOutlineColor(sf::Color color, std::size_t start, std::size_t length)
 {
 	ChunkBuilder chunk(length);
-	chunk.outline(color);
+	chunk.outlineColor = color;
 
 	replaceChunk(start, chunk);
 }
@@ -189,73 +388,256 @@ void sfv::VividText::setProperties(const ChunkBuilder& data, std::size_t start,
 
 void sfv::VividText::setString(const sf::String& text)
 {
-	m_string = "";
-	insert(text, 0);
+	m_string.assign(text);
+	resetString();
 }
 
-const sf::String& sfv::VividText::getString() const
+void sfv::VividText::setString(sf::String&& text)
 {
-	return m_string;
+	m_string.assign(std::move(text));
+	resetString();
 }
 
-const  sfv::Chunk& sfv::VividText::getChunk(std::size_t index) const
+void sfv::VividText::setString(std::u32string_view text)
 {
-	return m_chunks[index];
+	m_string.assign(text);
+	resetString();
 }
 
-const std::size_t sfv::VividText::getChunkIndex(std::size_t subIndex) const
+void sfv::VividText::setString(std::string_view text)
 {
-	const std::size_t chunkSize = m_chunks.size();
-	std::size_t chunkIndex = 0;
+	m_string.assign(text);
+	resetString();
+}
 
-	for (std::size_t chunk = 0; chunk != chunkSize; ++chunk) {
-		if (subIndex < chunkIndex + m_chunks[chunk].length) {
-			return chunk;
-		}
-		else {
-			chunkIndex += m_chunks[chunk].length;
-		}
+void sfv::VividText::setString(const std::string& text)
+{
+	setString(std::string_view(text));
+}
+
+void sfv::VividText::setString(const char* text)
+{
+	setString(std::string_view(text));
+}
+
+void sfv::VividText::resetString()
+{
+	m_chunks.clear();
+	m_edits.clear();
+	m_shifts.clear();
+	m_paintedEdits = 0;
+	m_glyphFillColors.clear();
+	m_glyphOutlineColors.clear();
+	m_glyphOffsets.clear();
+	m_lines.clear();
+	m_needsRewrap = false;
+	m_needsUpdate = true;
+	insertChunk(0, Chunk(m_string.getSize(), m_font));
+}
+
+void sfv::VividText::setMarkup(const sf::String& markup, const FontRegistry& fonts, const Chunk& base)
+{
+	Chunk start = base;
+	if (!start.font) {
+		start.font = m_font;
 	}
-	return NULL_INDEX;
+	MarkupParser& parser = markupParser();
+	parser.parse(markup, fonts, start);
+	m_string.assign(parser.getText());
+	m_chunks.assign(parser.getChunks());
+	countReallocations();
+	m_edits.clear();
+	m_shifts.clear();
+	m_paintedEdits = 0;
+	m_glyphFillColors.clear();
+	m_glyphOutlineColors.clear();
+	m_glyphOffsets.clear();
+	m_lines.clear();
+	m_needsRewrap = false;
+	m_needsUpdate = true;
 }
 
-sf::Vector2f sfv::VividText::findLocalCharacterPos(std::size_t subIndex) const
+void sfv::VividText::setMaxWidth(float width)
 {
-	sf::Vector2f position;
-
-	std::size_t offset = 0U;
-	sf::Uint32 previous = 0U;
-	for (const auto& chunk : m_chunks) {
-		const sf::Font* font = chunk.font;
-		const sf::Uint32 characterSize = chunk.characterSize;
-		const bool bold = (chunk.style & sf::Text::Style::Bold) != 0;
-		const float space = font->getGlyph(L' ', characterSize, bold).advance;
-		const float vSpace = font->getLineSpacing(characterSize);
-
-		for (std::size_t index = 0U; index != chunk.length; ++index) {
-			const auto& current = m_string[offset + index];
-			position.x += font->getKerning(previous, current, characterSize);
-
-			switch (current)
-			{
-			case ' ':
-				position.x = space;
-				break;
-			case '\t':
-				position.x += space * 4.f;
-				break;
-			case '\n':
-				position.y += vSpace;
-				break;
-			default:
-				position.x += font->getGlyph(current, characterSize, bold).advance;
-				break;
-			}
-			previous = current;
-		}
-		offset += chunk.length;
+	width = std::max(width, 0.f);
+	if (width == m_maxWidth) {
+		return;
+	}
+	// Lines only have their words while wrapping, and edits already lay their paragraphs out again
+	const bool rewrap = width != 0.f && m_maxWidth != 0.f && !m_needsUpdate && !m_lines.empty();
+	m_maxWidth = width;
+	if (rewrap) {
+		m_needsRewrap = true;
+		return;
+	}
+	m_lines.clear();
+	m_needsRewrap = false;
+	m_needsUpdate = true;
+}
+
+float sfv::VividText::getMaxWidth() const
+{
+	return m_maxWidth;
+}
+
+void sfv::VividText::setViewport(const sf::FloatRect& viewport)
+{
+	const bool culling = isCulling();
+	m_viewport = viewport;
+	m_followView = false;
+	// Lines outside the old viewport have no quads yet
+	if (culling && !isCulling()) {
+		m_lines.clear();
+		m_needsRewrap = false;
+		m_needsUpdate = true;
+	}
+}
+
+const sf::FloatRect& sfv::VividText::getViewport() const
+{
+	return m_viewport;
+}
+
+void sfv::VividText::setFollowView(bool follow)
+{
+	if (follow == m_followView) {
+		return;
+	}
+	if (!follow) {
+		setViewport(sf::FloatRect());
+		return;
+	}
+	m_followView = true;
+}
+
+bool sfv::VividText::getFollowView() const
+{
+	return m_followView;
+}
+
+void sfv::VividText::setGlyphAtlas(GlyphAtlas* atlas)
+{
+	m_atlas = atlas;
+	m_lines.clear();
+	m_needsUpdate = true;
+}
+
+sfv::GlyphAtlas* sfv::VividText::getGlyphAtlas() const
+{
+	return m_atlas;
+}
+
+void sfv::VividText::setWorkerPool(WorkerPool* pool)
+{
+	m_pool = pool;
+}
+
+sfv::WorkerPool* sfv::VividText::getWorkerPool() const
+{
+	return m_pool;
+}
+
+void sfv::VividText::setGeometrySink(GeometrySink* sink)
+{
+	m_sink = sink;
+	markChanged(GeometrySink::Fill, 0U, m_instances.size());
+	markChanged(GeometrySink::Outline, 0U, m_outlineInstances.size());
+}
+
+sfv::GeometrySink* sfv::VividText::getGeometrySink() const
+{
+	return m_sink;
+}
+
+void sfv::VividText::setLayoutCache(LayoutCache* cache)
+{
+	m_cache = cache;
+	// Geometry found in another cache may differ from what this one holds
+	m_shared.reset();
+	m_lines.clear();
+	m_needsRewrap = false;
+	m_needsUpdate = true;
+}
+
+sfv::LayoutCache* sfv::VividText::getLayoutCache() const
+{
+	return m_cache;
+}
+
+void sfv::VividText::setStyleTable(StyleTable& styles)
+{
+	m_chunks.setStyleTable(styles);
+}
+
+sfv::StyleTable& sfv::VividText::getStyleTable() const
+{
+	return m_chunks.getStyleTable();
+}
+
+void sfv::VividText::setCompactString(bool compact)
+{
+	m_string.setCompact(compact);
+}
+
+bool sfv::VividText::isCompactString() const
+{
+	return m_string.isCompact();
+}
+
+std::size_t sfv::VividText::getStringByteSize() const
+{
+	return m_string.getByteSize();
+}
+
+std::size_t sfv::VividText::getGeometryRevision() const
+{
+	ensureGeometryUpdate();
+	return m_revision;
+}
+
+void sfv::VividText::exportQuads(GeometrySink::Layer layer, std::vector<sf::Vertex>& vertices) const
+{
+	ensureGeometryUpdate();
+	const std::vector<GlyphInstance>& instances = getInstances(layer);
+	const GlyphShapeTable& shapes = getShapes();
+	vertices.clear();
+	vertices.reserve(instances.size() * 4);
+	for (const auto& instance : instances) {
+		appendQuad(instance, shapes[instance.shape], vertices);
 	}
-	return position;
+}
+
+const sf::String& sfv::VividText::getString() const
+{
+	return m_string.toString();
+}
+
+sfv::Chunk sfv::VividText::getChunk(std::size_t index) const
+{
+	return m_chunks.getChunk(index);
+}
+
+const std::size_t sfv::VividText::getChunkIndex(std::size_t subIndex) const
+{
+	const auto location = m_chunks.find(subIndex);
+	return location.index != m_chunks.size() ? location.index : NULL_INDEX;
+}
+
+sf::Vector2f sfv::VividText::findLocalCharacterPos(std::size_t subIndex) const
+{
+	ensureGeometryUpdate();
+	return TextLayout(m_string, m_chunks).findCharacterPos(getLines(), getOffsets(), subIndex);
+}
+
+sfv::TextLayout::Hit sfv::VividText::findLocalCharacter(sf::Vector2f point) const
+{
+	ensureGeometryUpdate();
+	return TextLayout(m_string, m_chunks).findCharacter(getLines(), getOffsets(), point);
+}
+
+sfv::TextLayout::Hit sfv::VividText::findGlobalCharacter(sf::Vector2f point) const
+{
+	return findLocalCharacter(getInverseTransform().transformPoint(point));
 }
 
 
@@ -286,413 +668,1430 @@ void sfv::VividText::insert(const sf::String& text, std::size_t index)
 	//first in last out container
 	m_string.insert(index, text);
 
-	insertChunk(index, Chunk(index, text.getSize(), m_font));
-	m_needsUpdate = true;
+	const Chunk chunk(text.getSize(), m_font);
+	// Inserted characters take the colors of their run
+	if (!m_glyphFillColors.empty()) {
+		m_glyphFillColors.insert(m_glyphFillColors.begin() + index, chunk.length, chunk.fillColor);
+	}
+	if (!m_glyphOutlineColors.empty()) {
+		m_glyphOutlineColors.insert(m_glyphOutlineColors.begin() + index, chunk.length, chunk.outlineColor);
+	}
+	if (!m_glyphOffsets.empty()) {
+		m_glyphOffsets.insert(m_glyphOffsets.begin() + index, chunk.length, sf::Vector2f());
+	}
+	insertChunk(index, chunk);
 }
 
 void sfv::VividText::erase(std::size_t start, std::size_t length)
 {
+	const std::size_t end = start + std::min(length, m_string.getSize() - std::min(start, m_string.getSize()));
 	m_string.erase(start, length);
 
+	if (!m_glyphFillColors.empty()) {
+		m_glyphFillColors.erase(m_glyphFillColors.begin() + start, m_glyphFillColors.begin() + end);
+	}
+	if (!m_glyphOutlineColors.empty()) {
+		m_glyphOutlineColors.erase(m_glyphOutlineColors.begin() + start, m_glyphOutlineColors.begin() + end);
+	}
+	if (!m_glyphOffsets.empty()) {
+		m_glyphOffsets.erase(m_glyphOffsets.begin() + start, m_glyphOffsets.begin() + end);
+	}
 	eraseChunk(start, length);
 }
 
-void sfv::VividText::draw(sf::RenderTarget& target, sf::RenderStates states) const
+void sfv::VividText::append(const sf::String& text, const Chunk& chunk)
 {
-	if (m_string.isEmpty()) {
-		return;
+	Chunk run = chunk;
+	run.length = text.getSize();
+	if (!run.font) {
+		run.font = m_font;
 	}
-	ensureGeometryUpdate();
-	states.transform *= getTransform();
+	appendRuns(text, &run, 1);
+}
 
-	if (m_vertices.empty()) {
-		return;
+void sfv::VividText::appendMarkup(const sf::String& markup, const FontRegistry& fonts, const Chunk& base)
+{
+	Chunk start = base;
+	if (!start.font) {
+		start.font = m_font;
 	}
+	MarkupParser& parser = markupParser();
+	parser.parse(markup, fonts, start);
+	const std::vector<Chunk>& runs = parser.getChunks();
+	appendRuns(parser.getText(), runs.data(), runs.size());
+}
 
-	const sf::Vertex* vertices = m_vertices.data();
-	const sf::Vertex* outline = m_outlineVertices.data();
-	const sf::Font* font = m_chunks.front().font;
-	std::size_t characterSize = m_chunks.front().characterSize;
-	std::size_t previous = 0;
-	std::size_t vertexLength = 0;
-	std::size_t prevOutline = 0;
-	std::size_t outlineLength = 0;
-	for (auto& chunk : m_chunks) {
-		if (font != chunk.font || characterSize != chunk.characterSize) {
-			states.texture = &font->getTexture(characterSize);
-			target.draw(outline + prevOutline, outlineLength, sf::PrimitiveType::Triangles, states);
-			font = chunk.font;
-			characterSize = chunk.characterSize;
-			prevOutline += outlineLength;
-			outlineLength = 0;
-		}
-		outlineLength += chunk.outlineLength;
-	}
-	states.texture = &font->getTexture(characterSize);
-	target.draw(outline + prevOutline, outlineLength, sf::PrimitiveType::Triangles, states);
-	font = m_chunks.front().font;
-	characterSize = m_chunks.front().characterSize;
-
-	for (auto& chunk : m_chunks) {
-		if (font != chunk.font || characterSize != chunk.characterSize) {
-			states.texture = &font->getTexture(characterSize);
-			target.draw(vertices + previous, vertexLength, sf::PrimitiveType::Triangles, states);
-			font = chunk.font;
-			characterSize = chunk.characterSize;
-			previous += vertexLength;
-			vertexLength = 0;
-		}
-		vertexLength += chunk.verticeLength;
+void sfv::VividText::setScrollback(std::size_t lines)
+{
+	m_scrollback = lines;
+	if (m_scrollback != 0) {
+		ensureGeometryUpdate();
+		trimScrollback(0U);
 	}
-	states.texture = &font->getTexture(characterSize);
-	target.draw(vertices + previous, vertexLength, sf::PrimitiveType::Triangles, states);
 }
 
-void sfv::VividText::eraseChunk(std::size_t subIndex, std::size_t length)
+std::size_t sfv::VividText::getScrollback() const
 {
-	if (m_chunks.empty()) {
+	return m_scrollback;
+}
+
+void sfv::VividText::setGlyphFillColors(const sf::Color* colors, std::size_t start, std::size_t count)
+{
+	setGlyphColors(m_glyphFillColors, &Chunk::fillColor, colors, start, count);
+}
+
+void sfv::VividText::setGlyphOutlineColors(const sf::Color* colors, std::size_t start, std::size_t count)
+{
+	setGlyphColors(m_glyphOutlineColors, &Chunk::outlineColor, colors, start, count);
+}
+
+void sfv::VividText::setGlyphOffsets(const sf::Vector2f* offsets, std::size_t start, std::size_t count)
+{
+	if (start >= m_string.getSize()) {
 		return;
 	}
-	const std::size_t start = getChunkIndex(subIndex);
-	const std::size_t end = getChunkIndex(subIndex + length);
-	auto chunkIter = m_chunks.begin() + end;
-
-	if (start != end) {
-		m_chunks[start].length -= (m_chunks[start].index + m_chunks[start].length) - subIndex;
-		m_chunks[end].length -= m_chunks[end].length - ((m_chunks[end].index + m_chunks[start].length) - (subIndex + length));
-		m_chunks[end].index = subIndex;
-		chunkIter = m_chunks.erase(m_chunks.begin() + start + (m_chunks[start].length != 0), chunkIter);
-		if (chunkIter != m_chunks.end()) {
-			++chunkIter;
-		}
+	count = std::min(count, m_string.getSize() - start);
+	if (m_glyphOffsets.empty()) {
+		m_glyphOffsets.resize(m_string.getSize());
 	}
+	std::copy(offsets, offsets + count, m_glyphOffsets.begin() + start);
+	// The quads move and the bounds with them
+	invalidate(start, count, count);
+}
 
-	const auto endChunk = m_chunks.end();
-	for (; chunkIter != endChunk; ++chunkIter) {
-		chunkIter->index -= length;
+void sfv::VividText::clearGlyphAttributes()
+{
+	if (m_glyphFillColors.empty() && m_glyphOutlineColors.empty() && m_glyphOffsets.empty()) {
+		return;
 	}
-	updateChunks(start);
+	m_glyphFillColors.clear();
+	m_glyphOutlineColors.clear();
+	m_glyphOffsets.clear();
+	m_lines.clear();
+	m_needsRewrap = false;
 	m_needsUpdate = true;
 }
 
-void sfv::VividText::insertChunk(std::size_t subIndex, const Chunk& chunk)
+void sfv::VividText::setGlyphColors(std::vector<sf::Color>& channel, sf::Color Chunk::* color, const sf::Color* colors, std::size_t start, std::size_t count)
 {
-	m_needsUpdate = true;
-
-	if (m_chunks.empty()) {
-		m_chunks.emplace_back(chunk);
+	if (start >= m_string.getSize()) {
 		return;
 	}
-	const std::size_t start = getChunkIndex(subIndex);
-	auto chunkIter = m_chunks.begin() + start;
-	if (chunk == m_chunks[start]) {
-		m_chunks[start].length += chunk.length;
-		++chunkIter;
-	}
-	else {
-		const std::size_t splicedSize = (chunkIter->index + chunkIter->length) - subIndex;
-		Chunk splicedChunk = *chunkIter;
-		chunkIter->length -= splicedSize;
-		splicedChunk.index = chunkIter->index + chunk.length + chunkIter->length;
-		splicedChunk.length = splicedSize;
-
-		if (chunkIter->length == 0) {
-			*chunkIter = chunk;
-			++chunkIter;
-			m_chunks.insert(chunkIter++, splicedChunk);
+	count = std::min(count, m_string.getSize() - start);
+	if (channel.empty()) {
+		// Every other character keeps the color of its run, or the one an open edit has queued for it
+		channel.reserve(m_string.getSize());
+		for (const ChunkTree::Run& run : m_chunks) {
+			channel.insert(channel.end(), run.length, m_chunks.getStyle(run).*color);
 		}
-		else {
-			++chunkIter;
-			m_chunks.insert(chunkIter++, chunk);
-			m_chunks.insert(chunkIter++, splicedChunk);
+		if (!m_edits.empty()) {
+			paintEdits(channel, &channel == &m_glyphFillColors ? &ChunkBuilder::fillColor : &ChunkBuilder::outlineColor, shiftEdits(0U), 0U);
 		}
 	}
-	const auto endChunk = m_chunks.end();
-	for (; chunkIter != endChunk; ++chunkIter) {
-		chunkIter->index += chunk.length;
+	// Colors queued before these must not cover them once the edit is committed
+	if (m_paintedEdits != m_edits.size()) {
+		const std::vector<Fragment> fragments = shiftEdits(m_paintedEdits);
+		paintEdits(m_glyphFillColors, &ChunkBuilder::fillColor, fragments, m_paintedEdits);
+		paintEdits(m_glyphOutlineColors, &ChunkBuilder::outlineColor, fragments, m_paintedEdits);
+		m_paintedEdits = m_edits.size();
+	}
+	std::copy(colors, colors + count, channel.begin() + start);
+
+	// Only the colors of the quads change, unless lines are waiting to be laid out again anyway
+	if (!m_needsUpdate && !m_lines.empty()) {
+		recolor(start, count, &channel == &m_glyphFillColors, &channel == &m_glyphOutlineColors);
+	}
+	else {
+		invalidate(start, count, count);
 	}
 }
 
-void sfv::VividText::replaceChunk(std::size_t subIndex, const ChunkBuilder& chunkData)
+sfv::TextLayout::GlyphAttributes sfv::VividText::getGlyphAttributes() const
+{
+	return {
+		m_glyphFillColors.empty() ? nullptr : m_glyphFillColors.data(),
+		m_glyphOutlineColors.empty() ? nullptr : m_glyphOutlineColors.data(),
+		m_glyphOffsets.empty() ? nullptr : m_glyphOffsets.data()
+	};
+}
+
+void sfv::VividText::beginEdit()
 {
-	const std::size_t start = getChunkIndex(subIndex);
-	const std::size_t end = getChunkIndex(subIndex + chunkData.length);
+	++m_editDepth;
+}
 
-	if (start == NULL_INDEX) {
+void sfv::VividText::commitEdit()
+{
+	if (m_editDepth == 0 || --m_editDepth != 0) {
 		return;
 	}
+	if (!m_edits.empty()) {
+		resolveEdits();
+	}
+	m_edits.clear();
+	m_shifts.clear();
+	m_paintedEdits = 0;
+}
 
-	auto chunkIter = m_chunks.begin() + start;
-	const auto startChunk = *chunkIter;
-	const auto endChunk = end != NULL_INDEX ? m_chunks[end] : startChunk;
-	const auto splicedSize = (chunkIter->index + chunkIter->length) - subIndex;
+bool sfv::VividText::isEditing() const
+{
+	return m_editDepth != 0;
+}
 
-	std::size_t offset = 0;
-	if (splicedSize != startChunk.length) {
-		chunkIter->length -= splicedSize;
-		chunkIter = m_chunks.insert(chunkIter + 1, startChunk);
-		chunkIter->index = subIndex;
-		++offset;
-	}
-	if (chunkData.length < splicedSize) {
-		chunkIter->length = chunkData.length;
-		chunkIter = m_chunks.insert(chunkIter + 1, startChunk);
-		chunkIter->index = subIndex + chunkData.length;
-		chunkIter->length = (startChunk.index + startChunk.length) - (subIndex + chunkData.length);
-		++offset;
-	}
-	else {
-		chunkIter->length = splicedSize;
-	}
-	if (end != -1 && start != end && subIndex + chunkData.length != endChunk.index) {
-		const std::size_t endSplice = (endChunk.index + endChunk.length) - (subIndex + chunkData.length);
-		chunkIter = m_chunks.insert(chunkIter + (end - start), endChunk); //std::prev(m_chunks.begin() + end + offset)
-		chunkIter->length -= endSplice;
+sfv::TextStatistics sfv::VividText::getStatistics() const
+{
+#ifdef SFV_STATISTICS
+	return m_statistics;
+#else
+	return TextStatistics();
+#endif
+}
+
+void sfv::VividText::resetStatistics()
+{
+#ifdef SFV_STATISTICS
+	m_statistics = TextStatistics();
+#endif
+}
 
-		auto endIter = std::next(chunkIter);
-		endIter->index += chunkIter->length;
-		endIter->length = endSplice;
-		++offset;
+sfv::TextStatistics sfv::VividText::getTotalStatistics()
+{
+	TextStatistics statistics = TextStatistics();
+#ifdef SFV_STATISTICS
+	for (std::size_t index = 0; index != COUNTER_COUNT; ++index) {
+		statistics.*COUNTERS[index] = totals[index].load(std::memory_order_relaxed);
 	}
+#endif
+	return statistics;
+}
 
-	const bool font = chunkData.font != nullptr;
-	for (std::size_t index = start + (splicedSize != startChunk.length), stop = (end == -1 ? m_chunks.size() : end + offset); index < stop; ++index) {
-		auto& chunk = m_chunks[index];
-		if (font) {
-			chunk.font = chunkData.font;
-		}
-		chunk.outlineThickness = chunkData.outlineThickness.value_or(chunk.outlineThickness);
-		chunk.characterSize = chunkData.characterSize.value_or(chunk.characterSize);
-		chunk.outlineColor = chunkData.outlineColor.value_or(chunk.outlineColor);
-		chunk.fillColor = chunkData.fillColor.value_or(chunk.fillColor);
-		chunk.style = chunkData.style.value_or(chunk.style);
+void sfv::VividText::resetTotalStatistics()
+{
+#ifdef SFV_STATISTICS
+	for (auto& total : totals) {
+		total.store(0U, std::memory_order_relaxed);
 	}
-	updateChunks(start);
-	m_needsUpdate = true;
+#endif
 }
 
-void sfv::VividText::updateChunks(std::size_t start)
+void sfv::VividText::setProfilerHooks(const ProfilerHooks& hooks)
 {
-	auto last = m_chunks.end();
-	auto first = std::next(m_chunks.begin(), start + 1);
-	auto result = first;
-	auto previous = std::prev(result);
+#ifdef SFV_STATISTICS
+	profilerHooks = hooks;
+#else
+	static_cast<void>(hooks);
+#endif
+}
 
-	while (first != last) {
-		if (*previous != *first) {
-			if (first != result) {
-				*result = std::move(*first);
-			}
-			previous = result;
-			++result;
-		}
-		else {
-			previous->length += first->length;
-		}
-		++first;
+void sfv::VividText::countReallocations() const
+{
+#ifdef SFV_STATISTICS
+	const std::size_t instanceCapacity = m_instances.capacity() + m_outlineInstances.capacity();
+	if (instanceCapacity != m_instanceCapacity) {
+		SFV_COUNT(instanceReallocations, 1U);
+		m_instanceCapacity = instanceCapacity;
 	}
-
-	m_chunks.erase(result, m_chunks.end());
+	if (m_chunks.capacity() != m_chunkCapacity) {
+		SFV_COUNT(chunkReallocations, 1U);
+		m_chunkCapacity = m_chunks.capacity();
+	}
+#endif
 }
 
+sfv::VividText::EditScope::EditScope(VividText& text)
+	: m_text(text)
+{
+	m_text.beginEdit();
+}
 
-void sfv::VividText::ensureGeometryUpdate() const
+sfv::VividText::EditScope::~EditScope()
 {
-	// Do nothing, if geometry has not changed
-	if (!m_needsUpdate)
+	m_text.commitEdit();
+}
+
+void sfv::VividText::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	SFV_ZONE("VividText::draw");
+	SFV_COUNT(draws, 1U);
+	if (m_string.isEmpty()) {
 		return;
-	// Mark geometry as updated
-	m_needsUpdate = false;
+	}
+	states.transform *= getTransform();
+	if (m_followView) {
+		// Bounding box of what the view shows, in the coordinates of the text
+		const sf::View& view = target.getView();
+		const sf::FloatRect area = view.getInverseTransform().transformRect(sf::FloatRect(-1.f, -1.f, 2.f, 2.f));
+		m_viewport = states.transform.getInverse().transformRect(area);
+	}
+	ensureGeometryUpdate();
 
-	// Clear the previous geometry
-	m_vertices.clear();
-	m_outlineVertices.clear();
-	m_bounds = sf::FloatRect();
+	if (getInstances(GeometrySink::Fill).empty()) {
+		return;
+	}
+	// Other texts may have added glyphs to the shared pages since the last draw
+	if (m_atlas) {
+		for (std::size_t page = 0; page != m_atlas->getPageCount(); ++page) {
+			m_atlas->getTexture(page);
+		}
+	}
+	flushChanges();
+	drawSegments(target, states, GeometrySink::Outline, &Segment::outlineCount);
+	drawSegments(target, states, GeometrySink::Fill, &Segment::instanceCount);
+}
 
-	if (m_string.isEmpty()) {
+void sfv::VividText::drawSegments(sf::RenderTarget& target, sf::RenderStates states, GeometrySink::Layer layer, std::size_t Segment::* count) const
+{
+	// Consecutive segments sharing a glyph texture are submitted together
+	const std::vector<Segment>& segments = getSegments();
+	const sf::Texture* texture = segments.front().texture;
+	std::size_t previous = 0;
+	std::size_t vertexLength = 0;
+	for (const auto& segment : segments) {
+		if (texture != segment.texture) {
+			if (vertexLength != 0) {
+				states.texture = texture;
+				drawVertices(target, states, layer, previous, vertexLength);
+			}
+			texture = segment.texture;
+			previous += vertexLength;
+			vertexLength = 0;
+		}
+		vertexLength += segment.*count;
+	}
+	if (vertexLength != 0) {
+		states.texture = texture;
+		drawVertices(target, states, layer, previous, vertexLength);
+	}
+}
+
+void sfv::VividText::drawVertices(sf::RenderTarget& target, const sf::RenderStates& states, GeometrySink::Layer layer, std::size_t first, std::size_t count) const
+{
+	SFV_COUNT(drawCalls, 1U);
+	if (m_sink) {
+		m_sink->draw(layer, target, first * 6, count * 6, states);
 		return;
 	}
-	float minX = std::numeric_limits<float>::max();
-	float minY = std::numeric_limits<float>::max();
-	float maxX = 0.f;
-	float maxY = 0.f;
+	// Instances only become triangles on their way to the target
+	const std::vector<sf::Vertex>& vertices = expand(layer, first, count);
+	target.draw(vertices.data(), vertices.size(), sf::PrimitiveType::Triangles, states);
+}
 
-	const auto getMaximum = [&](std::size_t start, auto fn)
-	{
-		const std::size_t newline = m_string.find('\n', start);
+void sfv::VividText::markChanged(GeometrySink::Layer layer, std::size_t begin, std::size_t end) const
+{
+	if (begin >= end) {
+		return;
+	}
+	m_changedBegin[layer] = std::min(m_changedBegin[layer], begin);
+	m_changedEnd[layer] = std::max(m_changedEnd[layer], end);
+}
 
-		const std::size_t startChunk = getChunkIndex(start);
-		const std::size_t endChunk = newline == std::string::npos ? m_chunks.size() : getChunkIndex(newline);
+void sfv::VividText::flushChanges() const
+{
+	// Ranges may reach past the end of an array that shrank, the sink still has to hear about it
+	for (int index = 0; index != GeometrySink::LayerCount; ++index) {
+		const GeometrySink::Layer layer = static_cast<GeometrySink::Layer>(index);
+		if (m_sink && m_changedBegin[layer] < m_changedEnd[layer]) {
+			const std::size_t size = layer == GeometrySink::Fill ? m_instances.size() : m_outlineInstances.size();
+			const std::size_t first = std::min(m_changedBegin[layer], size);
+			const std::size_t last = std::min(m_changedEnd[layer], size);
+			const std::vector<sf::Vertex>& vertices = expand(layer, first, last - first);
+			if (!m_sink->update(layer, size * 6, first * 6, vertices.data(), vertices.size())) {
+				expand(layer, 0U, size);
+				m_sink->update(layer, size * 6, 0U, vertices.data(), vertices.size());
+			}
+		}
+		m_changedBegin[layer] = NULL_INDEX;
+		m_changedEnd[layer] = 0U;
+	}
+}
 
-		auto begin = std::next(m_chunks.cbegin(), startChunk);
-		auto end = std::next(m_chunks.cbegin(), endChunk);
-		return std::max_element(begin, end, fn);
-	};
+const std::vector<sf::Vertex>& sfv::VividText::expand(GeometrySink::Layer layer, std::size_t first, std::size_t count) const
+{
+	const std::vector<GlyphInstance>& instances = getInstances(layer);
+	const GlyphShapeTable& shapes = getShapes();
+	std::vector<sf::Vertex>& vertices = expansionBuffer();
+	vertices.clear();
+	vertices.reserve(count * 6);
+	SFV_COUNT(vertices, count * 6);
+	for (std::size_t index = first; index != first + count; ++index) {
+		appendTriangles(instances[index], shapes[instances[index].shape], vertices);
+	}
+	return vertices;
+}
 
+void sfv::VividText::eraseChunk(std::size_t subIndex, std::size_t length)
+{
+	if (length == 0 || subIndex >= m_chunks.length()) {
+		return;
+	}
+	length = std::min(length, m_chunks.length() - subIndex);
+	invalidate(subIndex, length, 0);
+	// Only changes queued before an erase have to move past it
+	if (m_editDepth != 0 && !m_edits.empty()) {
+		m_shifts.push_back({ subIndex, length, 0U });
+	}
 
-	const std::size_t index = std::find(m_string.begin(), m_string.end(), '\n') - m_string.begin();
-	float x = 0.f;
-	float y = getMaximum(0, [&](const Chunk& left, const Chunk& right) {
-		return left.characterSize < right.characterSize;
-	})->characterSize;
-	std::size_t offset = 0U;
-	sf::Uint32 verticeOffset = 0U;
-	std::size_t outlineOffset = 0U;
-	sf::Uint32 prevChar = 0U;
-	float previousX = 0.f;
-	float curVSpace = getMaximum(0, [&](const Chunk& left, const Chunk& right) {
-		return left.getHeight() < right.getHeight();
-	})->getHeight();
-	for (auto& chunk : m_chunks) {
-		// No font or text: nothing to draw
-		if (!chunk.font)
-			continue;
+	const std::size_t first = splitChunk(subIndex);
+	const std::size_t last = splitChunk(subIndex + length);
+	m_chunks.erase(first, last - first);
+	if (first != 0) {
+		mergeChunks(first - 1, first);
+	}
+}
 
-		// Compute values related to the text style
-		const bool bold = (chunk.style & sf::Text::Style::Bold) != 0;
-		const bool underlined = (chunk.style & sf::Text::Style::Underlined) != 0;
-		const bool strikeThrough = (chunk.style & sf::Text::Style::StrikeThrough) != 0;
-		const float italic = (chunk.style & sf::Text::Style::Italic) ? 0.208f : 0.f; // 12 degrees
-		const float underlineOffset = chunk.font->getUnderlinePosition(chunk.characterSize);
-		const float underlineThickness = chunk.font->getUnderlineThickness(chunk.characterSize);
-
-		// Compute the location of the strike through dynamically
-		// We use the center point of the lowercase 'x' glyph as the reference
-		// We reuse the underline thickness as the thickness of the strike through as well
-		sf::FloatRect xBounds = chunk.font->getGlyph(L'x', chunk.characterSize, bold).bounds;
-		float strikeThroughOffset = xBounds.top + xBounds.height / 2.f;
-
-		// Precompute the variables needed by the algorithm
-		float hspace = static_cast<float>(chunk.font->getGlyph(L' ', chunk.characterSize, bold).advance);
-		// Create one quad for each character
-		minX = std::min(minX, static_cast<float>(chunk.characterSize));
-		minY = std::min(minY, static_cast<float>(chunk.characterSize));
-		for (std::size_t i = 0U; i != chunk.length; ++i)
-		{
-			sf::Uint32 curChar = m_string[offset + i];
+void sfv::VividText::insertChunk(std::size_t subIndex, const Chunk& chunk)
+{
+	if (chunk.length == 0) {
+		return;
+	}
+	invalidate(subIndex, 0, chunk.length);
+	if (m_editDepth != 0 && !m_edits.empty()) {
+		m_shifts.push_back({ subIndex, 0U, chunk.length });
+	}
 
-			// Apply the kerning offset
-			x += chunk.font->getKerning(prevChar, curChar, chunk.characterSize);
-			prevChar = curChar;
+	if (m_chunks.empty()) {
+		m_chunks.insert(0, chunk);
+		countReallocations();
+		return;
+	}
+	// Grow the run the text lands in when it shares its attributes
+	const std::size_t start = std::min(m_chunks.find(subIndex).index, m_chunks.size() - 1);
+	if (chunk == m_chunks.getStyle(m_chunks[start])) {
+		m_chunks.resize(start, m_chunks[start].length + chunk.length);
+		return;
+	}
+	const std::size_t index = splitChunk(subIndex);
+	m_chunks.insert(index, chunk);
+	countReallocations();
+	mergeChunks(index == 0 ? 0 : index - 1, index + 1);
+}
 
-			if (curChar == L'\n')
-			{
-				minX = std::min(minX, x);
-				minY = std::min(minY, y);
+void sfv::VividText::replaceChunk(std::size_t subIndex, const ChunkBuilder& chunkData)
+{
+	if (subIndex >= m_chunks.length()) {
+		return;
+	}
+	const std::size_t length = std::min(chunkData.length, m_chunks.length() - subIndex);
+	if (m_editDepth != 0) {
+		if (length != 0) {
+			m_edits.push_back({ subIndex, subIndex + length, m_shifts.size(), chunkData });
+		}
+		return;
+	}
+	// Characters with their own colors take the new ones too
+	if (chunkData.fillColor && !m_glyphFillColors.empty()) {
+		std::fill(m_glyphFillColors.begin() + subIndex, m_glyphFillColors.begin() + subIndex + length, *chunkData.fillColor);
+	}
+	if (chunkData.outlineColor && !m_glyphOutlineColors.empty()) {
+		std::fill(m_glyphOutlineColors.begin() + subIndex, m_glyphOutlineColors.begin() + subIndex + length, *chunkData.outlineColor);
+	}
+	const bool recolorable = canRecolor(subIndex, length, chunkData);
+	if (!recolorable) {
+		invalidate(subIndex, length, length);
+	}
 
-				if (underlined) {
-					addLine(previousX, m_vertices, x - previousX, y, chunk.fillColor, underlineOffset, underlineThickness);
+	const std::size_t first = splitChunk(subIndex);
+	const std::size_t last = splitChunk(subIndex + length);
+	for (std::size_t index = first; index != last; ++index) {
+		m_chunks.restyle(index, chunkData);
+	}
+	mergeChunks(first == 0 ? 0 : first - 1, last);
 
-					if (chunk.outlineThickness != 0) {
-						addLine(previousX, m_outlineVertices, x - previousX, y, chunk.outlineColor, underlineOffset, underlineThickness, chunk.outlineThickness);
-					}
-				}
-				if (strikeThrough)
-				{
-					addLine(previousX, m_vertices, x - previousX, y, chunk.fillColor, strikeThroughOffset, underlineThickness);
+	if (recolorable) {
+		recolor(subIndex, length, chunkData.fillColor.has_value(), chunkData.outlineColor.has_value());
+	}
+}
 
-					if (chunk.outlineThickness != 0) {
-						addLine(previousX, m_outlineVertices, x - previousX, y, chunk.outlineColor, strikeThroughOffset, underlineThickness, chunk.outlineThickness);
-					}
+void sfv::VividText::appendRuns(const sf::String& text, const Chunk* runs, std::size_t count)
+{
+	if (text.isEmpty()) {
+		return;
+	}
+	if (m_scrollback != 0) {
+		// Every newline starts a line, as does the first character of an empty text
+		m_lineCount += static_cast<std::size_t>(std::count(text.begin(), text.end(), L'\n')) + (m_string.isEmpty() ? 1U : 0U);
+	}
+	std::size_t position = m_string.getSize();
+	m_string.insert(position, text);
+	for (std::size_t index = 0; index != count; ++index) {
+		const Chunk& run = runs[index];
+		if (!m_glyphFillColors.empty()) {
+			m_glyphFillColors.insert(m_glyphFillColors.end(), run.length, run.fillColor);
+		}
+		if (!m_glyphOutlineColors.empty()) {
+			m_glyphOutlineColors.insert(m_glyphOutlineColors.end(), run.length, run.outlineColor);
+		}
+		if (!m_glyphOffsets.empty()) {
+			m_glyphOffsets.insert(m_glyphOffsets.end(), run.length, sf::Vector2f());
+		}
+		insertChunk(position, run);
+		position += run.length;
+	}
+	// The lines are only laid out to be counted once there may be too many
+	if (m_scrollback != 0 && m_lineCount > m_scrollback + m_scrollback / 8) {
+		ensureGeometryUpdate();
+		trimScrollback(m_scrollback / 8);
+	}
+}
+
+void sfv::VividText::trimScrollback(std::size_t slack)
+{
+	const std::vector<Line>& lines = getLines();
+	if (lines.size() <= m_scrollback + slack) {
+		return;
+	}
+	// Only whole paragraphs go, the first one left is the only one laid out again
+	// since its baseline no longer comes through a newline. The lines after it just move up.
+	std::size_t drop = lines.size() - m_scrollback;
+	while (drop < lines.size() && m_string[lines[drop].start - 1] != L'\n') {
+		++drop;
+	}
+	if (drop != lines.size()) {
+		m_lineCount = lines.size() - drop;
+		erase(0U, lines[drop].start);
+	}
+}
+
+std::size_t sfv::VividText::splitChunk(std::size_t subIndex)
+{
+	// Make a run start at subIndex and return its index
+	const auto location = m_chunks.find(subIndex);
+	if (location.index == m_chunks.size() || location.start == subIndex) {
+		return location.index;
+	}
+	ChunkTree::Run splicedChunk = m_chunks[location.index];
+	splicedChunk.length = static_cast<std::uint32_t>(location.start + splicedChunk.length - subIndex);
+	m_chunks.resize(location.index, subIndex - location.start);
+	m_chunks.insert(location.index + 1, splicedChunk);
+	SFV_COUNT(chunkSplits, 1U);
+	countReallocations();
+	return location.index + 1;
+}
+
+void sfv::VividText::mergeChunks(std::size_t first, std::size_t last)
+{
+	// Fold every run from first + 1 to last into its neighbour when they match
+	for (std::size_t index = first + 1; index <= last && index < m_chunks.size();) {
+		const ChunkTree::Run& previous = m_chunks[index - 1];
+		const ChunkTree::Run& current = m_chunks[index];
+		if (previous.style == current.style) {
+			m_chunks.resize(index - 1, previous.length + current.length);
+			m_chunks.erase(index);
+			SFV_COUNT(chunkMerges, 1U);
+			--last;
+		}
+		else {
+			++index;
+		}
+	}
+}
+
+void sfv::VividText::resolveEdits()
+{
+	SFV_ZONE("VividText::edit");
+	std::vector<Fragment> starts = shiftEdits(0U);
+	if (starts.empty()) {
+		return;
+	}
+	// Characters with their own colors take the queued ones they don't hold yet
+	paintEdits(m_glyphFillColors, &ChunkBuilder::fillColor, starts, m_paintedEdits);
+	paintEdits(m_glyphOutlineColors, &ChunkBuilder::outlineColor, starts, m_paintedEdits);
+	std::vector<Fragment> ends = starts;
+	std::sort(starts.begin(), starts.end(), [](const Fragment& left, const Fragment& right) {
+		return left.start < right.start;
+	});
+	std::sort(ends.begin(), ends.end(), [](const Fragment& left, const Fragment& right) {
+		return left.end < right.end;
+	});
+	const std::size_t begin = starts.front().start;
+	const std::size_t end = ends.back().end;
+
+	// Colors are patched in the cached geometry when nothing else changes, as with a single setter
+	bool recolorable = m_shifts.empty();
+	for (auto edit = m_edits.begin(); recolorable && edit != m_edits.end(); ++edit) {
+		recolorable = canRecolor(edit->start, edit->end - edit->start, edit->chunk);
+	}
+
+	// Walk the runs once, cutting them where a change starts or ends. The changes covering a piece
+	// are applied in the order they were made, and the runs around the range are rebuilt for merging.
+	const auto location = m_chunks.find(begin);
+	std::size_t first = location.index;
+	// Every style derived on the way holds a reference until the runs hold their own
+	StyleTable& styles = m_chunks.getStyleTable();
+	std::vector<ChunkTree::Run> runs;
+	std::vector<StyleTable::Id> derived;
+	if (first != 0) {
+		--first;
+		runs.push_back(m_chunks[first]);
+	}
+	std::size_t count = runs.size();
+	std::vector<std::size_t> active;
+	std::size_t nextStart = 0;
+	std::size_t nextEnd = 0;
+	auto run = m_chunks.at(location.index);
+	for (std::size_t runStart = location.start; run != m_chunks.end() && runStart < end; ++run, ++count) {
+		const std::size_t runEnd = runStart + run->length;
+		for (std::size_t position = runStart; position != runEnd;) {
+			for (; nextEnd != ends.size() && ends[nextEnd].end <= position; ++nextEnd) {
+				active.erase(std::find(active.begin(), active.end(), ends[nextEnd].edit));
+			}
+			for (; nextStart != starts.size() && starts[nextStart].start <= position; ++nextStart) {
+				active.insert(std::upper_bound(active.begin(), active.end(), starts[nextStart].edit), starts[nextStart].edit);
+			}
+			std::size_t stop = runEnd;
+			if (nextStart != starts.size()) {
+				stop = std::min(stop, starts[nextStart].start);
+			}
+			if (nextEnd != ends.size()) {
+				stop = std::min(stop, ends[nextEnd].end);
+			}
+			ChunkTree::Run chunk{ static_cast<std::uint32_t>(stop - position), run->style };
+			for (const std::size_t edit : active) {
+				chunk.style = styles.derive(chunk.style, m_edits[edit].chunk);
+				derived.push_back(chunk.style);
+			}
+			appendRun(runs, chunk);
+			position = stop;
+		}
+		runStart = runEnd;
+	}
+	if (run != m_chunks.end()) {
+		appendRun(runs, *run);
+		++count;
+	}
+	m_chunks.replace(first, count, runs);
+	for (const StyleTable::Id style : derived) {
+		styles.release(style);
+	}
+	countReallocations();
+
+	if (recolorable) {
+		for (const PendingEdit& edit : m_edits) {
+			recolor(edit.start, edit.end - edit.start, edit.chunk.fillColor.has_value(), edit.chunk.outlineColor.has_value());
+		}
+	}
+	else {
+		invalidate(begin, end - begin, end - begin);
+	}
+}
+
+std::vector<sfv::VividText::Fragment> sfv::VividText::shiftEdits(std::size_t firstEdit) const
+{
+	// Carry each change past the inserts and erases made after it.
+	// Text inserted inside a range wasn't there when the change was made, so it cuts the range in two.
+	std::vector<Fragment> fragments;
+	fragments.reserve(m_edits.size() - firstEdit);
+	for (std::size_t edit = firstEdit; edit != m_edits.size(); ++edit) {
+		const std::size_t first = fragments.size();
+		fragments.push_back({ m_edits[edit].start, m_edits[edit].end, edit });
+		for (std::size_t shift = m_edits[edit].shift; shift != m_shifts.size(); ++shift) {
+			const PendingShift& change = m_shifts[shift];
+			const auto erase = [&change](std::size_t position) {
+				return position <= change.start ? position : std::max(position, change.start + change.removed) - change.removed;
+			};
+			for (std::size_t index = first, count = fragments.size(); index != count; ++index) {
+				Fragment& fragment = fragments[index];
+				fragment.start = erase(fragment.start);
+				fragment.end = erase(fragment.end);
+				if (change.inserted == 0 || fragment.end <= change.start) {
+					continue;
+				}
+				if (fragment.start >= change.start) {
+					fragment.start += change.inserted;
+					fragment.end += change.inserted;
+					continue;
 				}
+				const std::size_t end = fragment.end + change.inserted;
+				fragment.end = change.start;
+				fragments.push_back({ change.start + change.inserted, end, edit });
+			}
+		}
+	}
+	fragments.erase(std::remove_if(fragments.begin(), fragments.end(), [](const Fragment& fragment) {
+		return fragment.start >= fragment.end;
+	}), fragments.end());
+	return fragments;
+}
+
+void sfv::VividText::paintEdits(std::vector<sf::Color>& channel, std::optional<sf::Color> ChunkBuilder::* color, const std::vector<Fragment>& fragments, std::size_t firstEdit) const
+{
+	if (channel.empty()) {
+		return;
+	}
+	for (const Fragment& fragment : fragments) {
+		const std::optional<sf::Color>& value = m_edits[fragment.edit].chunk.*color;
+		if (fragment.edit >= firstEdit && value) {
+			std::fill(channel.begin() + fragment.start, channel.begin() + fragment.end, *value);
+		}
+	}
+}
+
+bool sfv::VividText::canRecolor(std::size_t subIndex, std::size_t length, const ChunkBuilder& chunk) const
+{
+	// Only colors may change, and the cached geometry has to be current
+	if (chunk.font || chunk.style || chunk.characterSize || chunk.outlineThickness || m_needsUpdate || m_lines.empty()) {
+		return false;
+	}
+	// Underlines and strike throughs span whole runs, so splitting or merging
+	// the runs around them changes the geometry
+	const std::size_t first = subIndex == 0 ? 0 : subIndex - 1;
+	const std::size_t last = std::min(subIndex + length, m_string.getSize() - 1);
+	const sf::Uint32 lines = sf::Text::Style::Underlined | sf::Text::Style::StrikeThrough;
+	const std::size_t stop = getChunkIndex(last);
+	auto current = m_chunks.at(getChunkIndex(first));
+	for (std::size_t index = getChunkIndex(first); index <= stop; ++index, ++current) {
+		if ((m_chunks.getStyle(*current).style & lines) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
 
-				const float height = getMaximum(offset + i + 1, [](const Chunk& left, const Chunk& right) {
-					return left.getHeight() < right.getHeight();
-				})->getHeight();
-				const float max = std::max(height, curVSpace);
-				y += std::round(height * 0.65f + max * 0.25f + curVSpace * 0.1f);
-				
-				curVSpace = height;
-				x = 0.f;
-				previousX = 0.f;
-				maxX = std::max(maxX, x);
-				maxY = std::max(maxY, y);
+void sfv::VividText::recolor(std::size_t subIndex, std::size_t length, bool fillChanged, bool outlineChanged)
+{
+	if (!fillChanged && !outlineChanged) {
+		return;
+	}
+	++m_revision;
+	const std::size_t end = subIndex + length;
+	// Lines without quads take the new colors once they are laid out
+	const auto windowEnd = m_lines.begin() + m_windowEnd;
+	auto line = std::upper_bound(m_lines.begin(), m_lines.end(), subIndex, [](std::size_t index, const Line& line) {
+		return index < line.start;
+	}) - 1;
+	line = std::max(line, m_lines.begin() + m_windowBegin);
+	for (; line < windowEnd && line->start < end; ++line) {
+		const std::size_t segmentEnd = std::next(line) != windowEnd ? std::next(line)->segmentBegin : m_segments.size();
+		std::size_t instance = line->instanceBegin;
+		std::size_t outline = line->outlineBegin;
+		for (std::size_t index = line->segmentBegin; index != segmentEnd; ++index) {
+			const Segment& segment = m_segments[index];
+			const std::size_t first = line->start + segment.offset;
+			const std::size_t stop = first + segment.length;
+			if (stop <= subIndex || first >= end) {
+				instance += segment.instanceCount;
+				outline += segment.outlineCount;
 				continue;
 			}
-			// Handle special characters
-			else if ((curChar == ' ') || (curChar == '\t'))
-			{
-				// Update the current bounds (min coordinates)
-				minX = std::min(minX, x);
-				minY = std::min(minY, y);
-
-				switch (curChar)
-				{
-				case ' ':  x += hspace;        break;
-				case '\t': x += hspace * 4;    break;
+			// Whitespace has no quad, every other character has one in each array it's drawn in.
+			// Each quad takes the color of its character, or of its run without one.
+			const bool outlined = segment.outlineCount != 0;
+			std::size_t glyph = instance;
+			std::size_t glyphOutline = outline;
+			const auto location = m_chunks.find(first);
+			auto run = m_chunks.at(location.index);
+			std::size_t runEnd = location.start + run->length;
+			for (std::size_t character = first; character != std::min(stop, end); ++character) {
+				const sf::Uint32 current = m_string[character];
+				if (current == L' ' || current == L'\t' || current == L'\n') {
+					continue;
+				}
+				while (character >= runEnd) {
+					++run;
+					runEnd += run->length;
+				}
+				if (character >= subIndex) {
+					if (fillChanged) {
+						m_instances[glyph].color = m_glyphFillColors.empty() ? m_chunks.getStyle(*run).fillColor : m_glyphFillColors[character];
+						markChanged(GeometrySink::Fill, glyph, glyph + 1);
+					}
+					if (outlineChanged && outlined) {
+						m_outlineInstances[glyphOutline].color = m_glyphOutlineColors.empty() ? m_chunks.getStyle(*run).outlineColor : m_glyphOutlineColors[character];
+						markChanged(GeometrySink::Outline, glyphOutline, glyphOutline + 1);
+					}
 				}
+				++glyph;
+				glyphOutline += outlined ? 1 : 0;
+			}
+			instance += segment.instanceCount;
+			outline += segment.outlineCount;
+		}
+	}
+}
 
-				// Update the current bounds (max coordinates)
-				maxX = std::max(maxX, x);
-				maxY = std::max(maxY, y);
+void sfv::VividText::invalidate(std::size_t start, std::size_t removed, std::size_t inserted)
+{
+	// Wrapping the old lines at the new width is no use once they change
+	if (m_needsRewrap) {
+		m_needsRewrap = false;
+		m_lines.clear();
+		m_needsUpdate = true;
+	}
+	const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(inserted) - static_cast<std::ptrdiff_t>(removed);
+	if (!m_needsUpdate) {
+		m_dirtyStart = start;
+		m_dirtyEnd = start + inserted;
+		m_dirtyDelta = delta;
+		m_needsUpdate = true;
+		return;
+	}
+	// Move the pending range along with the edit before widening it
+	const auto shift = [&](std::size_t position) {
+		return position >= start + removed ? position + delta : std::min(position, start);
+	};
+	m_dirtyStart = std::min(shift(m_dirtyStart), start);
+	m_dirtyEnd = std::max(shift(m_dirtyEnd), start + inserted);
+	m_dirtyDelta += delta;
+}
+
+
+
+void sfv::VividText::moveToAtlas(Segment& segment, GlyphInstance* fill, GlyphInstance* stroke) const
+{
+	// Fill and outline quads go in together so they end up on the same page
+	std::vector<sf::IntRect> rects;
+	rects.reserve(segment.instanceCount + segment.outlineCount);
+	for (std::size_t index = 0; index != segment.instanceCount; ++index) {
+		rects.push_back(m_shapes[fill[index].shape].textureRect);
+	}
+	for (std::size_t index = 0; index != segment.outlineCount; ++index) {
+		rects.push_back(m_shapes[stroke[index].shape].textureRect);
+	}
+	std::vector<sf::IntRect> placed(rects.size());
+
+	const std::size_t generation = GlyphCache::get(*segment.font).getGeneration();
+	const std::size_t page = m_atlas->insert(*segment.texture, generation, rects.data(), rects.size(), placed.data());
+	if (page == static_cast<std::size_t>(-1)) {
+		// Glyphs too large for a page keep drawing from the font
+		return;
+	}
+
+	// Lines sample the white square at (1, 1) found on every page, so only glyphs move
+	const auto remap = [this, &placed](GlyphInstance* quads, std::size_t count, std::size_t rect) {
+		for (std::size_t index = 0; index != count; ++index, ++rect) {
+			GlyphShape shape = m_shapes[quads[index].shape];
+			shape.textureRect = placed[rect];
+			quads[index].shape = m_shapes.intern(shape);
+		}
+	};
+	remap(fill, segment.instanceCount, 0);
+	remap(stroke, segment.outlineCount, segment.instanceCount);
+	segment.texture = &m_atlas->getTexture(page);
+}
+
+void sfv::VividText::prepare(const std::vector<const VividText*>& texts, WorkerPool& pool)
+{
+	SFV_ZONE("VividText::prepare");
+	// A text listed twice would be laid out by two workers at once
+	std::vector<const VividText*> pending;
+	std::vector<const VividText*> shared;
+	for (const VividText* text : texts) {
+		if (text && text->canShareGeometry()) {
+			shared.push_back(text);
+		}
+		else if (text && (text->m_needsUpdate || text->m_needsRewrap)) {
+			pending.push_back(text);
+		}
+	}
+	std::sort(pending.begin(), pending.end());
+	pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+	// sf::Font is not thread safe, so glyphs are loaded one text after the other
+	for (const VividText* text : pending) {
+		text->warmGlyphs();
+	}
+
+	// Hand the largest edits out first so they do not end up last on a single worker
+	const auto cost = [](const VividText* text) {
+		return text->m_lines.empty() ? text->m_string.getSize() : text->m_dirtyEnd - text->m_dirtyStart;
+	};
+	std::stable_sort(pending.begin(), pending.end(), [&cost](const VividText* left, const VividText* right) {
+		return cost(left) > cost(right);
+	});
+	std::vector<std::atomic<bool>> missed(pending.size());
+	pool.run(pending.size(), [&pending, &missed](std::size_t index) {
+		pending[index]->layoutGeometry(nullptr, &missed[index]);
+	});
+	for (std::size_t index = 0; index != pending.size(); ++index) {
+		if (missed[index].load()) {
+			// Some metric was not warmed, the text starts over reading its fonts
+			const VividText* text = pending[index];
+			text->m_lines.clear();
+			text->m_needsRewrap = false;
+			text->m_needsUpdate = true;
+			text->layoutGeometry(nullptr);
+		}
+	}
+
+	// Font textures and glyph atlases are not thread safe either, and the lines around the viewports
+	// are only known once every line is in place
+	for (const VividText* text : pending) {
+		text->cullGeometry();
+		text->resolveGeometry();
+		text->countReallocations();
+	}
+	// Misses read glyph textures too
+	for (const VividText* text : shared) {
+		text->shareGeometry();
+	}
+}
+
+void sfv::VividText::ensureGeometryUpdate() const
+{
+	if (canShareGeometry()) {
+		shareGeometry();
+		m_lineCount = getLines().size();
+		return;
+	}
+	if (m_shared) {
+		// The text stopped sharing, it lays itself out from scratch
+		m_shared.reset();
+		m_needsRewrap = false;
+		m_needsUpdate = true;
+	}
+	// Only large edits are worth handing to the pool
+	const bool parallel = m_pool && m_needsUpdate && (m_lines.empty() ? m_string.getSize() : m_dirtyEnd - m_dirtyStart) >= PARALLEL_LAYOUT_LENGTH;
+	layoutGeometry(parallel ? m_pool : nullptr);
+	cullGeometry();
+	resolveGeometry();
+	countReallocations();
+	m_lineCount = m_lines.size();
+}
+
+bool sfv::VividText::canShareGeometry() const
+{
+	return m_cache && !m_atlas && !m_sink && !isCulling() && !m_string.isEmpty() && !m_chunks.empty()
+		&& m_glyphFillColors.empty() && m_glyphOutlineColors.empty() && m_glyphOffsets.empty();
+}
+
+void sfv::VividText::shareGeometry() const
+{
+	if (m_shared && !m_needsUpdate && !m_needsRewrap) {
+		return;
+	}
+	SFV_ZONE("VividText::share");
+	m_needsUpdate = false;
+	m_needsRewrap = false;
+	++m_revision;
+	m_shared = m_cache->get(m_string, m_chunks, m_maxWidth);
+	m_bounds = m_shared->bounds;
+
+	// With no lines of its own, the next edit or new width lays the text out from scratch
+	m_lines = std::vector<Line>();
+	m_words = std::vector<TextLayout::Word>();
+	m_offsets = std::vector<float>();
+	m_instances = std::vector<GlyphInstance>();
+	m_outlineInstances = std::vector<GlyphInstance>();
+	m_segments = std::vector<Segment>();
+	m_shapes = GlyphShapeTable();
+	m_dirtyDelta = 0;
+	m_windowBegin = 0U;
+	m_windowEnd = 0U;
+	m_unresolvedBegin = 0U;
+	m_unresolvedEnd = 0U;
+	countReallocations();
+}
+
+const std::vector<sfv::TextLayout::Line>& sfv::VividText::getLines() const
+{
+	return m_shared ? m_shared->lines : m_lines;
+}
+
+const std::vector<float>& sfv::VividText::getOffsets() const
+{
+	return m_shared ? m_shared->offsets : m_offsets;
+}
+
+const std::vector<sfv::TextLayout::Segment>& sfv::VividText::getSegments() const
+{
+	return m_shared ? m_shared->segments : m_segments;
+}
+
+const std::vector<sfv::GlyphInstance>& sfv::VividText::getInstances(GeometrySink::Layer layer) const
+{
+	if (m_shared) {
+		return layer == GeometrySink::Fill ? m_shared->instances : m_shared->outlineInstances;
+	}
+	return layer == GeometrySink::Fill ? m_instances : m_outlineInstances;
+}
+
+const sfv::GlyphShapeTable& sfv::VividText::getShapes() const
+{
+	return m_shared ? m_shared->shapes : m_shapes;
+}
+
+void sfv::VividText::warmGlyphs() const
+{
+	if ((!m_needsUpdate && !m_needsRewrap) || m_string.isEmpty() || m_chunks.empty()) {
+		return;
+	}
+	const TextLayout layout(m_string, m_chunks);
+	const std::size_t size = m_string.getSize();
+	if (m_lines.empty() || m_needsRewrap) {
+		layout.warm(0U, size);
+		return;
+	}
+	// The paragraphs holding the edit are laid out again, see layoutGeometry
+	const std::size_t firstLine = findParagraphLine(m_dirtyStart);
+	const std::size_t newline = m_string.find(L'\n', std::min(m_dirtyEnd, size), size);
+	layout.warm(firstLine < m_lines.size() ? m_lines[firstLine].start : 0U, newline != size ? newline + 1 : size);
+}
+
+void sfv::VividText::layoutGeometry(WorkerPool* pool, std::atomic<bool>* missed) const
+{
+	if (m_needsRewrap) {
+		rewrapGeometry(missed);
+	}
+	// Do nothing, if geometry has not changed
+	if (!m_needsUpdate)
+		return;
+	// Mark geometry as updated
+	m_needsUpdate = false;
+	++m_revision;
+	SFV_PASS(layouts, "VividText::layout");
+
+	if (m_string.isEmpty() || m_chunks.empty()) {
+		markChanged(GeometrySink::Fill, 0U, m_instances.size());
+		markChanged(GeometrySink::Outline, 0U, m_outlineInstances.size());
+		m_instances.clear();
+		m_outlineInstances.clear();
+		m_lines.clear();
+		m_segments.clear();
+		m_words.clear();
+		m_offsets.clear();
+		m_windowBegin = 0U;
+		m_windowEnd = 0U;
+		m_unresolvedBegin = 0U;
+		m_unresolvedEnd = 0U;
+		m_bounds = sf::FloatRect();
+		return;
+	}
+	if (m_lines.empty()) {
+		m_dirtyStart = 0U;
+		m_dirtyEnd = m_string.getSize();
+		m_dirtyDelta = 0;
+		markChanged(GeometrySink::Fill, 0U, m_instances.size());
+		markChanged(GeometrySink::Outline, 0U, m_outlineInstances.size());
+		m_shapes.clear();
+		m_instances.clear();
+		m_outlineInstances.clear();
+		m_segments.clear();
+		m_words.clear();
+		m_offsets.clear();
+		m_windowBegin = 0U;
+		m_windowEnd = 0U;
+	}
 
-				// Next glyph, no need to create a quad for whitespace
+	// Paragraphs before the one holding the first edited character are kept as they are
+	const std::size_t firstLine = findParagraphLine(m_dirtyStart);
+	const std::size_t size = m_string.getSize();
+
+	// Lay lines out again until they line up with the cached ones past the edit
+	LayoutBuffers& buffers = layoutBuffers();
+	std::vector<std::size_t>& starts = buffers.starts;
+	std::size_t tail = m_lines.size();
+	std::size_t start = firstLine < m_lines.size() ? m_lines[firstLine].start : 0U;
+	// While wrapping, a cached line only started a paragraph if the newline before it was there already
+	const std::size_t reusable = m_maxWidth > 0.f ? m_dirtyEnd + 1 : m_dirtyEnd;
+	while (true) {
+		starts.push_back(start);
+		const std::size_t newline = m_string.find(L'\n', start, size);
+		if (newline == size) {
+			break;
+		}
+		const std::size_t next = newline + 1;
+		if (next >= reusable && next != size) {
+			const std::size_t previous = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(next) - m_dirtyDelta);
+			const auto match = std::lower_bound(m_lines.begin() + std::min(firstLine + 1, m_lines.size()), m_lines.end(), previous, [](const Line& line, std::size_t index) {
+				return line.start < index;
+			});
+			if (match != m_lines.end() && match->start == previous) {
+				tail = static_cast<std::size_t>(match - m_lines.begin());
+				break;
+			}
+		}
+		start = next;
+	}
+
+	std::vector<Line>& lines = buffers.lines;
+	std::vector<GlyphInstance>& instances = buffers.instances;
+	std::vector<GlyphInstance>& outlineInstances = buffers.outlineInstances;
+	std::vector<Segment>& segments = buffers.segments;
+	std::vector<TextLayout::Word>& words = buffers.words;
+	std::vector<float>& offsets = buffers.offsets;
+	const TextLayout layout(m_string, m_chunks, m_maxWidth, getGlyphAttributes(), missed);
+	if (pool) {
+		// Every metric is loaded before the workers start
+		const std::size_t newline = m_string.find(L'\n', starts.back(), size);
+		layout.warm(starts.front(), newline != size ? newline + 1 : size);
+	}
+	const Line* previous = firstLine != 0 ? &m_lines[firstLine - 1] : nullptr;
+	const bool culling = isCulling();
+	if (culling) {
+		// Only the lines around the viewport get quads, once every line is in place
+		truncateWindow(firstLine);
+		layout.boundLines(starts, previous, pool, lines, words, offsets);
+	}
+	else {
+		layout.layoutLines(starts, previous, pool, m_shapes, lines, instances, outlineInstances, segments, words, offsets);
+		SFV_COUNT(quads, instances.size() + outlineInstances.size());
+	}
+	const float shift = tail != m_lines.size() ? lines.back().y + TextLayout::lineAdvance(lines.back().height, m_lines[tail].height) - m_lines[tail].y : 0.f;
+
+	// Splice the new lines in and move the reused ones after them
+	const bool reuse = tail != m_lines.size();
+	const std::size_t wordBegin = firstLine < m_lines.size() ? m_lines[firstLine].wordBegin : 0U;
+	const std::size_t wordEnd = reuse ? m_lines[tail].wordBegin : m_words.size();
+	const std::size_t offsetBegin = firstLine < m_lines.size() ? m_lines[firstLine].start : 0U;
+	const std::size_t offsetEnd = reuse ? m_lines[tail].start : m_offsets.size();
+	for (auto line = m_lines.begin() + tail; line != m_lines.end(); ++line) {
+		line->start += m_dirtyDelta;
+		line->wordBegin = line->wordBegin - wordEnd + wordBegin + words.size();
+		line->y += shift;
+		line->minY += shift;
+		line->maxY += shift;
+	}
+	for (auto& line : lines) {
+		line.wordBegin += wordBegin;
+	}
+	splice(m_words, wordBegin, wordEnd, words);
+	splice(m_offsets, offsetBegin, offsetEnd, offsets);
+	m_dirtyDelta = 0;
+	if (culling) {
+		splice(m_lines, firstLine, tail, lines);
+		m_bounds = TextLayout::getBounds(m_lines);
+		return;
+	}
+
+	const std::size_t instanceBegin = firstLine < m_lines.size() ? m_lines[firstLine].instanceBegin : 0U;
+	const std::size_t outlineBegin = firstLine < m_lines.size() ? m_lines[firstLine].outlineBegin : 0U;
+	const std::size_t segmentBegin = firstLine < m_lines.size() ? m_lines[firstLine].segmentBegin : 0U;
+	const std::size_t instanceEnd = reuse ? m_lines[tail].instanceBegin : m_instances.size();
+	const std::size_t outlineEnd = reuse ? m_lines[tail].outlineBegin : m_outlineInstances.size();
+	const std::size_t segmentEnd = reuse ? m_lines[tail].segmentBegin : m_segments.size();
+
+	if (shift != 0.f) {
+		for (auto instance = m_instances.begin() + instanceEnd; instance != m_instances.end(); ++instance) {
+			instance->position.y += shift;
+		}
+		for (auto instance = m_outlineInstances.begin() + outlineEnd; instance != m_outlineInstances.end(); ++instance) {
+			instance->position.y += shift;
+		}
+	}
+	for (auto line = m_lines.begin() + tail; line != m_lines.end(); ++line) {
+		line->instanceBegin = line->instanceBegin - instanceEnd + instanceBegin + instances.size();
+		line->outlineBegin = line->outlineBegin - outlineEnd + outlineBegin + outlineInstances.size();
+		line->segmentBegin = line->segmentBegin - segmentEnd + segmentBegin + segments.size();
+	}
+	for (auto& line : lines) {
+		line.instanceBegin += instanceBegin;
+		line.outlineBegin += outlineBegin;
+		line.segmentBegin += segmentBegin;
+	}
+	// Everything past the new lines moves when they changed size or height
+	const bool moved = shift != 0.f || instances.size() != instanceEnd - instanceBegin || outlineInstances.size() != outlineEnd - outlineBegin;
+	const std::size_t instanceSize = m_instances.size();
+	const std::size_t outlineSize = m_outlineInstances.size();
+	splice(m_instances, instanceBegin, instanceEnd, instances);
+	splice(m_outlineInstances, outlineBegin, outlineEnd, outlineInstances);
+	markChanged(GeometrySink::Fill, instanceBegin, moved ? std::max(instanceSize, m_instances.size()) : instanceBegin + instances.size());
+	markChanged(GeometrySink::Outline, outlineBegin, moved ? std::max(outlineSize, m_outlineInstances.size()) : outlineBegin + outlineInstances.size());
+	splice(m_segments, segmentBegin, segmentEnd, segments);
+	splice(m_lines, firstLine, tail, lines);
+	m_windowBegin = 0U;
+	m_windowEnd = m_lines.size();
+	m_unresolvedBegin = firstLine;
+	m_unresolvedEnd = firstLine + lines.size();
+
+	m_bounds = TextLayout::getBounds(m_lines);
+}
+
+std::size_t sfv::VividText::findParagraphLine(std::size_t index) const
+{
+	const auto found = std::upper_bound(m_lines.begin(), m_lines.end(), index, [](std::size_t index, const Line& line) {
+		return index < line.start;
+	});
+	std::size_t line = found == m_lines.begin() ? 0U : static_cast<std::size_t>(found - m_lines.begin()) - 1;
+	while (line != 0 && line < m_lines.size() && m_string[m_lines[line].start - 1] != L'\n') {
+		--line;
+	}
+	return line;
+}
+
+void sfv::VividText::rewrapGeometry(std::atomic<bool>* missed) const
+{
+	m_needsRewrap = false;
+	SFV_PASS(rewraps, "VividText::rewrap");
+
+	// Paragraphs breaking at the same places as before keep their quads and only move down,
+	// the others are laid out again from the first one that changed
+	const TextLayout layout(m_string, m_chunks, m_maxWidth, getGlyphAttributes(), missed);
+	const bool culling = isCulling();
+	std::vector<Line> lines;
+	std::vector<Line> paragraph;
+	std::vector<GlyphInstance> instances;
+	std::vector<GlyphInstance> outlineInstances;
+	std::vector<Segment> segments;
+	std::size_t firstLine = m_lines.size();
+	std::size_t end = 0U;
+	for (std::size_t begin = 0U; begin != m_lines.size(); begin = end) {
+		end = begin + 1;
+		while (end != m_lines.size() && m_string[m_lines[end].start - 1] != L'\n') {
+			++end;
+		}
+		const Line& first = m_lines[begin];
+		const std::size_t wordEnd = end != m_lines.size() ? m_lines[end].wordBegin : m_words.size();
+		const auto location = m_chunks.find(first.start);
+		paragraph.clear();
+		layout.measureLines(first.start, m_words.data() + first.wordBegin, wordEnd - first.wordBegin, first.wordBegin, m_chunks.at(location.index), location.start, paragraph);
+
+		bool same = paragraph.size() == end - begin;
+		for (std::size_t index = 0; same && index != paragraph.size(); ++index) {
+			same = paragraph[index].start == m_lines[begin + index].start;
+		}
+		if (firstLine == m_lines.size()) {
+			if (same) {
 				continue;
 			}
+			firstLine = begin;
+		}
 
+		const Line* previous = !lines.empty() ? &lines.back() : begin != 0 ? &m_lines[begin - 1] : nullptr;
+		if (same) {
+			const float shift = TextLayout::baseline(previous, first) - first.y;
+			if (culling) {
+				for (std::size_t index = begin; index != end; ++index) {
+					Line line = m_lines[index];
+					line.y += shift;
+					line.minY += shift;
+					line.maxY += shift;
+					lines.push_back(line);
+				}
+				continue;
+			}
+			const std::size_t instanceEnd = end != m_lines.size() ? m_lines[end].instanceBegin : m_instances.size();
+			const std::size_t outlineEnd = end != m_lines.size() ? m_lines[end].outlineBegin : m_outlineInstances.size();
+			const std::size_t segmentEnd = end != m_lines.size() ? m_lines[end].segmentBegin : m_segments.size();
+			for (std::size_t index = begin; index != end; ++index) {
+				Line line = m_lines[index];
+				line.instanceBegin = line.instanceBegin - first.instanceBegin + instances.size();
+				line.outlineBegin = line.outlineBegin - first.outlineBegin + outlineInstances.size();
+				line.segmentBegin = line.segmentBegin - first.segmentBegin + segments.size();
+				line.y += shift;
+				line.minY += shift;
+				line.maxY += shift;
+				lines.push_back(line);
+			}
+			for (std::size_t index = first.instanceBegin; index != instanceEnd; ++index) {
+				instances.push_back(m_instances[index]);
+				instances.back().position.y += shift;
+			}
+			for (std::size_t index = first.outlineBegin; index != outlineEnd; ++index) {
+				outlineInstances.push_back(m_outlineInstances[index]);
+				outlineInstances.back().position.y += shift;
+			}
+			segments.insert(segments.end(), m_segments.begin() + first.segmentBegin, m_segments.begin() + segmentEnd);
+			continue;
+		}
 
-			const sf::Glyph& glyph = chunk.font->getGlyph(curChar, chunk.characterSize, bold);
-			if (chunk.outlineThickness != 0)
-			{
-				const sf::Glyph& glyph = chunk.font->getGlyph(curChar, chunk.characterSize, bold, chunk.outlineThickness);
-				const float left = glyph.bounds.left;
-				const float top = glyph.bounds.top;
-				const float right = glyph.bounds.left + glyph.bounds.width;
-				const float bottom = glyph.bounds.top + glyph.bounds.height;
-				addGlyphQuad(m_outlineVertices, sf::Vector2f(x, y), chunk.outlineColor, glyph, italic, chunk.outlineThickness);
-
-				// Update the current bounds with the outlined glyph bounds
-				minX = std::min(minX, x + left - italic * bottom - chunk.outlineThickness);
-				maxX = std::max(maxX, x + right - italic * top - chunk.outlineThickness);
-				minY = std::min(minY, y + top - chunk.outlineThickness);
-				maxY = std::max(maxY, y + bottom - chunk.outlineThickness);
+		auto chunk = m_chunks.at(location.index);
+		std::size_t chunkStart = location.start;
+		for (auto& line : paragraph) {
+			line.y = TextLayout::baseline(previous, line);
+			for (; chunk != m_chunks.end() && chunkStart + chunk->length <= line.start; ++chunk) {
+				chunkStart += chunk->length;
+			}
+			if (culling) {
+				layout.boundLine(line, chunk, chunkStart, m_offsets.data() + line.start);
 			}
 			else {
-				// Update the current bounds with the non outlined glyph bounds
-				const float left = glyph.bounds.left;
-				const float top = glyph.bounds.top;
-				const float right = glyph.bounds.left + glyph.bounds.width;
-				const float bottom = glyph.bounds.top + glyph.bounds.height;
-				minX = std::min(minX, x + left - italic * bottom);
-				maxX = std::max(maxX, x + right - italic * top);
-				minY = std::min(minY, y + top);
-				maxY = std::max(maxY, y + bottom);
+				layout.layoutLine(line, chunk, chunkStart, m_shapes, instances, outlineInstances, segments, m_offsets.data() + line.start);
+				SFV_COUNT(quads, instances.size() - line.instanceBegin + outlineInstances.size() - line.outlineBegin);
 			}
+			lines.push_back(line);
+			previous = &lines.back();
+		}
+	}
+	if (firstLine == m_lines.size()) {
+		return;
+	}
+	++m_revision;
+	if (culling) {
+		truncateWindow(firstLine);
+		splice(m_lines, firstLine, m_lines.size(), lines);
+		m_bounds = TextLayout::getBounds(m_lines);
+		return;
+	}
 
+	const Line& first = m_lines[firstLine];
+	for (auto& line : lines) {
+		line.instanceBegin += first.instanceBegin;
+		line.outlineBegin += first.outlineBegin;
+		line.segmentBegin += first.segmentBegin;
+	}
+	const std::size_t instanceBegin = first.instanceBegin;
+	const std::size_t outlineBegin = first.outlineBegin;
+	const std::size_t segmentBegin = first.segmentBegin;
+	const std::size_t instanceSize = m_instances.size();
+	const std::size_t outlineSize = m_outlineInstances.size();
+	splice(m_instances, instanceBegin, m_instances.size(), instances);
+	splice(m_outlineInstances, outlineBegin, m_outlineInstances.size(), outlineInstances);
+	markChanged(GeometrySink::Fill, instanceBegin, std::max(instanceSize, m_instances.size()));
+	markChanged(GeometrySink::Outline, outlineBegin, std::max(outlineSize, m_outlineInstances.size()));
+	splice(m_segments, segmentBegin, m_segments.size(), segments);
+	splice(m_lines, firstLine, m_lines.size(), lines);
+	m_windowEnd = m_lines.size();
+	m_unresolvedBegin = firstLine;
+	m_unresolvedEnd = m_lines.size();
+
+	m_bounds = TextLayout::getBounds(m_lines);
+}
 
-			addGlyphQuad(m_vertices, sf::Vector2f(x, y), chunk.fillColor, glyph, italic);
-			// Advance to the next character
-			x += glyph.advance;
+void sfv::VividText::cullGeometry() const
+{
+	std::size_t begin = 0U;
+	std::size_t end = m_lines.size();
+	if (isCulling()) {
+		const float top = m_viewport.top;
+		const float bottom = m_viewport.top + m_viewport.height;
+		if (top >= m_windowTop && bottom <= m_windowBottom) {
+			return;
 		}
-		offset += chunk.length;
-		// If we're using the underlined style, add the last line
-		if (underlined && (x > 0))
-		{
-			addLine(previousX, m_vertices, x - previousX, y, chunk.fillColor, underlineOffset, underlineThickness);
-
-			if (chunk.outlineThickness != 0)
-				addLine(previousX, m_outlineVertices, x - previousX, y, chunk.outlineColor, underlineOffset, underlineThickness, chunk.outlineThickness);
+		begin = end = 0U;
+		if (m_viewport.height > 0.f) {
+			// Keep a viewport of lines on each side, the window only moves once
+			// the viewport comes within half of it from an edge
+			const float margin = m_viewport.height;
+			const auto above = [](const Line& line, float y) {
+				return line.y < y;
+			};
+			begin = static_cast<std::size_t>(std::lower_bound(m_lines.begin(), m_lines.end(), top - margin, above) - m_lines.begin());
+			end = static_cast<std::size_t>(std::lower_bound(m_lines.begin(), m_lines.end(), bottom + margin, above) - m_lines.begin());
+			// Glyphs reach past their baseline on both sides
+			begin = begin != 0 ? begin - 1 : 0U;
+			end = std::min(end + 1, m_lines.size());
+			m_windowTop = top - margin / 2.f;
+			m_windowBottom = bottom + margin / 2.f;
 		}
-
-		// If we're using the strike through style, add the last line across all characters
-		if (strikeThrough && (x > 0))
-		{
-			addLine(previousX, m_vertices, x - previousX, y, chunk.fillColor, strikeThroughOffset, underlineThickness);
-
-			if (chunk.outlineThickness != 0)
-				addLine(previousX, m_outlineVertices, x - previousX, y, chunk.outlineColor, strikeThroughOffset, underlineThickness, chunk.outlineThickness);
+	}
+	if (begin == m_windowBegin && end == m_windowEnd) {
+		return;
+	}
+	++m_revision;
+	SFV_PASS(windowLayouts, "VividText::cull");
+	markChanged(GeometrySink::Fill, 0U, m_instances.size());
+	markChanged(GeometrySink::Outline, 0U, m_outlineInstances.size());
+
+	// Lines staying in the window keep their quads, the others are laid out around them
+	std::size_t keepBegin = std::max(begin, m_windowBegin);
+	std::size_t keepEnd = std::min(end, m_windowEnd);
+	if (keepBegin >= keepEnd) {
+		m_instances.clear();
+		m_outlineInstances.clear();
+		m_segments.clear();
+		keepBegin = begin;
+		keepEnd = begin;
+		m_windowEnd = begin;
+	}
+	const std::size_t instanceBegin = keepBegin != keepEnd ? m_lines[keepBegin].instanceBegin : 0U;
+	const std::size_t outlineBegin = keepBegin != keepEnd ? m_lines[keepBegin].outlineBegin : 0U;
+	const std::size_t segmentBegin = keepBegin != keepEnd ? m_lines[keepBegin].segmentBegin : 0U;
+	const std::size_t instanceEnd = keepEnd != m_windowEnd ? m_lines[keepEnd].instanceBegin : m_instances.size();
+	const std::size_t outlineEnd = keepEnd != m_windowEnd ? m_lines[keepEnd].outlineBegin : m_outlineInstances.size();
+	const std::size_t segmentEnd = keepEnd != m_windowEnd ? m_lines[keepEnd].segmentBegin : m_segments.size();
+
+	const TextLayout layout(m_string, m_chunks, m_maxWidth, getGlyphAttributes());
+	const auto layoutRange = [this, &layout](std::size_t first, std::size_t last, std::vector<GlyphInstance>& instances, std::vector<GlyphInstance>& outlineInstances, std::vector<Segment>& segments) {
+		if (first == last) {
+			return;
 		}
-		chunk.outlineLength = m_outlineVertices.size() - outlineOffset;
-		chunk.verticeLength = m_vertices.size() - verticeOffset;
-		outlineOffset = m_outlineVertices.size();
-		verticeOffset = m_vertices.size();
-		previousX = x;
+		const auto location = m_chunks.find(m_lines[first].start);
+		auto chunk = m_chunks.at(location.index);
+		std::size_t chunkStart = location.start;
+		for (std::size_t index = first; index != last; ++index) {
+			Line& line = m_lines[index];
+			for (; chunk != m_chunks.end() && chunkStart + chunk->length <= line.start; ++chunk) {
+				chunkStart += chunk->length;
+			}
+			layout.layoutLine(line, chunk, chunkStart, m_shapes, instances, outlineInstances, segments);
+			SFV_COUNT(quads, instances.size() - line.instanceBegin + outlineInstances.size() - line.outlineBegin);
+		}
+	};
+	std::vector<GlyphInstance> instances;
+	std::vector<GlyphInstance> outlineInstances;
+	std::vector<Segment> segments;
+	layoutRange(keepEnd, end, instances, outlineInstances, segments);
+	for (std::size_t index = keepEnd; index != end; ++index) {
+		m_lines[index].instanceBegin += instanceEnd;
+		m_lines[index].outlineBegin += outlineEnd;
+		m_lines[index].segmentBegin += segmentEnd;
+	}
+	splice(m_instances, instanceEnd, m_instances.size(), instances);
+	splice(m_outlineInstances, outlineEnd, m_outlineInstances.size(), outlineInstances);
+	splice(m_segments, segmentEnd, m_segments.size(), segments);
+
+	instances.clear();
+	outlineInstances.clear();
+	segments.clear();
+	layoutRange(begin, keepBegin, instances, outlineInstances, segments);
+	for (std::size_t index = keepBegin; index != end; ++index) {
+		m_lines[index].instanceBegin = m_lines[index].instanceBegin - instanceBegin + instances.size();
+		m_lines[index].outlineBegin = m_lines[index].outlineBegin - outlineBegin + outlineInstances.size();
+		m_lines[index].segmentBegin = m_lines[index].segmentBegin - segmentBegin + segments.size();
+	}
+	splice(m_instances, 0U, instanceBegin, instances);
+	splice(m_outlineInstances, 0U, outlineBegin, outlineInstances);
+	splice(m_segments, 0U, segmentBegin, segments);
+
+	m_windowBegin = begin;
+	m_windowEnd = end;
+	m_unresolvedBegin = begin;
+	m_unresolvedEnd = end;
+	markChanged(GeometrySink::Fill, 0U, m_instances.size());
+	markChanged(GeometrySink::Outline, 0U, m_outlineInstances.size());
+}
+
+void sfv::VividText::truncateWindow(std::size_t line) const
+{
+	// The lines may have moved, so the window has to be found again
+	m_windowTop = std::numeric_limits<float>::max();
+	m_windowBottom = std::numeric_limits<float>::lowest();
+	if (line >= m_windowEnd) {
+		return;
+	}
+	++m_revision;
+	markChanged(GeometrySink::Fill, 0U, m_instances.size());
+	markChanged(GeometrySink::Outline, 0U, m_outlineInstances.size());
+	if (line <= m_windowBegin) {
+		m_instances.clear();
+		m_outlineInstances.clear();
+		m_segments.clear();
+		m_windowBegin = 0U;
+		m_windowEnd = 0U;
+		return;
 	}
+	m_instances.resize(m_lines[line].instanceBegin);
+	m_outlineInstances.resize(m_lines[line].outlineBegin);
+	m_segments.resize(m_lines[line].segmentBegin);
+	m_windowEnd = line;
+}
 
-	// Update the bounding rectangle
-	m_bounds.left = minX;
-	m_bounds.top = minY;
-	m_bounds.width = maxX - minX;
-	m_bounds.height = maxY - minY;
+bool sfv::VividText::isCulling() const
+{
+	return m_followView || (m_viewport.width > 0.f && m_viewport.height > 0.f);
 }
 
+void sfv::VividText::resolveGeometry() const
+{
+	if (m_unresolvedBegin == m_unresolvedEnd) {
+		return;
+	}
+	SFV_ZONE("VividText::resolve");
+	// Segments carried over from the previous layout already have their texture
+	const Line& first = m_lines[m_unresolvedBegin];
+	const std::size_t segmentEnd = m_unresolvedEnd != m_windowEnd ? m_lines[m_unresolvedEnd].segmentBegin : m_segments.size();
+	std::size_t instance = first.instanceBegin;
+	std::size_t outline = first.outlineBegin;
+	for (auto segment = m_segments.begin() + first.segmentBegin; segment != m_segments.begin() + segmentEnd; ++segment) {
+		if (!segment->texture) {
+			segment->texture = GlyphCache::getTexture(*segment->font, segment->characterSize);
+			if (m_atlas && segment->texture) {
+				moveToAtlas(*segment, m_instances.data() + instance, m_outlineInstances.data() + outline);
+			}
+		}
+		instance += segment->instanceCount;
+		outline += segment->outlineCount;
+	}
+	m_unresolvedBegin = 0U;
+	m_unresolvedEnd = 0U;
+}
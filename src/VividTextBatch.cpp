@@ -0,0 +1,224 @@
+#include "VividTextBatch.h"
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <algorithm>
+
+namespace
+{
+	const std::size_t NO_REVISION = static_cast<std::size_t>(-1);
+
+	bool sameTransform(const sf::Transform& left, const sf::Transform& right)
+	{
+		return std::equal(left.getMatrix(), left.getMatrix() + 16, right.getMatrix());
+	}
+}
+
+sfv::VividTextBatch::VividTextBatch()
+{
+}
+
+void sfv::VividTextBatch::add(const VividText& text)
+{
+	if (contains(text)) {
+		return;
+	}
+	m_indices[&text] = m_members.size();
+	m_members.push_back({ &text, sf::Transform(), NO_REVISION, {} });
+}
+
+void sfv::VividTextBatch::remove(const VividText& text)
+{
+	const auto found = m_indices.find(&text);
+	if (found == m_indices.end()) {
+		return;
+	}
+	const std::size_t index = found->second;
+	release(m_members[index]);
+	m_indices.erase(found);
+
+	// Fill the gap with the last member
+	if (index != m_members.size() - 1) {
+		m_members[index] = std::move(m_members.back());
+		m_indices[m_members[index].text] = index;
+	}
+	m_members.pop_back();
+}
+
+bool sfv::VividTextBatch::contains(const VividText& text) const
+{
+	return m_indices.find(&text) != m_indices.end();
+}
+
+std::size_t sfv::VividTextBatch::size() const
+{
+	return m_members.size();
+}
+
+void sfv::VividTextBatch::clear()
+{
+	m_members.clear();
+	m_indices.clear();
+	m_streams.clear();
+}
+
+void sfv::VividTextBatch::update() const
+{
+	for (auto& member : m_members) {
+		const std::size_t revision = member.text->getGeometryRevision();
+		const sf::Transform& transform = member.text->getTransform();
+		if (revision != member.revision || !sameTransform(transform, member.transform)) {
+			member.transform = transform;
+			member.revision = revision;
+			write(member);
+		}
+	}
+	// Members that grew leave holes behind, squeeze them out once they make up half a stream
+	for (std::size_t stream = 0; stream != m_streams.size(); ++stream) {
+		if (m_streams[stream].unused != 0 && m_streams[stream].unused * 2 >= m_streams[stream].vertices.size()) {
+			compact(stream);
+		}
+	}
+}
+
+std::size_t sfv::VividTextBatch::getBatchCount() const
+{
+	update();
+	std::size_t count = 0;
+	for (const auto& stream : m_streams) {
+		count += stream.vertices.size() != stream.unused ? 1 : 0;
+	}
+	return count;
+}
+
+void sfv::VividTextBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	update();
+	const GeometrySink::Layer layers[2] = { GeometrySink::Outline, GeometrySink::Fill };
+	for (const GeometrySink::Layer layer : layers) {
+		for (const auto& stream : m_streams) {
+			if (stream.layer != layer || stream.vertices.size() == stream.unused) {
+				continue;
+			}
+			states.texture = stream.texture;
+			target.draw(stream.vertices.data(), stream.vertices.size(), sf::PrimitiveType::Triangles, states);
+		}
+	}
+}
+
+std::size_t sfv::VividTextBatch::findStream(const sf::Texture* texture, GeometrySink::Layer layer) const
+{
+	for (std::size_t index = 0; index != m_streams.size(); ++index) {
+		if (m_streams[index].texture == texture && m_streams[index].layer == layer) {
+			return index;
+		}
+	}
+	m_streams.push_back({ texture, layer, {}, 0U });
+	return m_streams.size() - 1;
+}
+
+void sfv::VividTextBatch::release(Member& member) const
+{
+	// Collapsed triangles cover no pixel, the slot stays until the stream is compacted
+	for (const auto& range : member.ranges) {
+		Stream& stream = m_streams[range.stream];
+		std::fill(stream.vertices.begin() + range.begin, stream.vertices.begin() + range.begin + range.count, sf::Vertex());
+		stream.unused += range.count;
+	}
+	member.ranges.clear();
+}
+
+void sfv::VividTextBatch::write(Member& member) const
+{
+	const VividText& text = *member.text;
+	if (text.m_atlas) {
+		for (std::size_t page = 0; page != text.m_atlas->getPageCount(); ++page) {
+			text.m_atlas->getTexture(page);
+		}
+	}
+
+	// Count the vertices going to each stream
+	m_counts.clear();
+	const auto count = [this](const sf::Texture* texture, GeometrySink::Layer layer, std::size_t vertices) {
+		if (vertices == 0) {
+			return;
+		}
+		const std::size_t stream = findStream(texture, layer);
+		for (auto& range : m_counts) {
+			if (range.stream == stream) {
+				range.count += vertices;
+				return;
+			}
+		}
+		m_counts.push_back({ stream, 0U, vertices });
+	};
+	const std::vector<TextLayout::Segment>& segments = text.getSegments();
+	for (const auto& segment : segments) {
+		count(segment.texture, GeometrySink::Fill, segment.instanceCount * 6);
+		count(segment.texture, GeometrySink::Outline, segment.outlineCount * 6);
+	}
+
+	// Keep the slots when the member still needs the same room, move it to the end of the streams otherwise
+	bool fits = m_counts.size() == member.ranges.size();
+	for (std::size_t index = 0; fits && index != m_counts.size(); ++index) {
+		fits = m_counts[index].stream == member.ranges[index].stream && m_counts[index].count == member.ranges[index].count;
+	}
+	if (!fits) {
+		release(member);
+		for (auto& range : m_counts) {
+			Stream& stream = m_streams[range.stream];
+			range.begin = stream.vertices.size();
+			stream.vertices.resize(stream.vertices.size() + range.count);
+			member.ranges.push_back(range);
+		}
+	}
+
+	// Expand and transform the quads into their slots
+	m_counts = member.ranges;
+	const sf::Transform& transform = member.transform;
+	const GlyphShapeTable& shapes = text.getShapes();
+	const auto emit = [&](const sf::Texture* texture, GeometrySink::Layer layer, const std::vector<GlyphInstance>& instances, std::size_t first, std::size_t length) {
+		if (length == 0) {
+			return;
+		}
+		const std::size_t stream = findStream(texture, layer);
+		auto range = std::find_if(m_counts.begin(), m_counts.end(), [stream](const Range& range) {
+			return range.stream == stream;
+		});
+		m_scratch.clear();
+		for (std::size_t index = first; index != first + length; ++index) {
+			appendTriangles(instances[index], shapes[instances[index].shape], m_scratch);
+		}
+		sf::Vertex* destination = m_streams[stream].vertices.data() + range->begin;
+		for (const auto& vertex : m_scratch) {
+			*destination = vertex;
+			destination->position = transform.transformPoint(vertex.position);
+			++destination;
+		}
+		range->begin += m_scratch.size();
+	};
+	std::size_t instance = 0;
+	std::size_t outline = 0;
+	for (const auto& segment : segments) {
+		emit(segment.texture, GeometrySink::Fill, text.getInstances(GeometrySink::Fill), instance, segment.instanceCount);
+		emit(segment.texture, GeometrySink::Outline, text.getInstances(GeometrySink::Outline), outline, segment.outlineCount);
+		instance += segment.instanceCount;
+		outline += segment.outlineCount;
+	}
+}
+
+void sfv::VividTextBatch::compact(std::size_t stream) const
+{
+	std::vector<sf::Vertex> vertices;
+	vertices.reserve(m_streams[stream].vertices.size() - m_streams[stream].unused);
+	for (auto& member : m_members) {
+		for (auto& range : member.ranges) {
+			if (range.stream != stream) {
+				continue;
+			}
+			const auto begin = m_streams[stream].vertices.begin() + range.begin;
+			range.begin = vertices.size();
+			vertices.insert(vertices.end(), begin, begin + range.count);
+		}
+	}
+	m_streams[stream].vertices.swap(vertices);
+	m_streams[stream].unused = 0;
+}
@@ -0,0 +1,130 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+sfv::WorkerPool::WorkerPool(std::size_t workerCount)
+	: m_task(nullptr),
+	m_round(0),
+	m_finished(0),
+	m_stopping(false)
+{
+	workerCount = std::max<std::size_t>(workerCount, 1U);
+	for (std::size_t worker = 0; worker != workerCount; ++worker) {
+		m_queues.emplace_back(new Queue());
+	}
+	// Worker 0 is whoever calls run
+	for (std::size_t worker = 1; worker != workerCount; ++worker) {
+		m_threads.emplace_back(&WorkerPool::loop, this, worker);
+	}
+}
+
+sfv::WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+}
+
+std::size_t sfv::WorkerPool::getWorkerCount() const
+{
+	return m_queues.size();
+}
+
+void sfv::WorkerPool::run(std::size_t count, const Task& task)
+{
+	if (count == 0) {
+		return;
+	}
+	if (m_threads.empty() || count == 1) {
+		for (std::size_t index = 0; index != count; ++index) {
+			task(index);
+		}
+		return;
+	}
+
+	// Deal the tasks out in turn so every queue starts with one of the largest ones
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (std::size_t index = 0; index != count; ++index) {
+			Queue& queue = *m_queues[index % m_queues.size()];
+			std::lock_guard<std::mutex> queueLock(queue.mutex);
+			queue.tasks.push_back(index);
+		}
+		m_task = &task;
+		m_finished = 0;
+		++m_round;
+	}
+	m_wake.notify_all();
+	work(0, task);
+
+	// Every thread has to be done with this round before task goes out of scope
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() {
+		return m_finished == m_threads.size();
+	});
+	m_task = nullptr;
+}
+
+void sfv::WorkerPool::loop(std::size_t worker)
+{
+	std::size_t round = 0;
+	while (true) {
+		const Task* task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this, round]() {
+				return m_stopping || m_round != round;
+			});
+			if (m_stopping) {
+				return;
+			}
+			round = m_round;
+			task = m_task;
+		}
+		work(worker, *task);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (++m_finished == m_threads.size()) {
+				m_done.notify_one();
+			}
+		}
+	}
+}
+
+void sfv::WorkerPool::work(std::size_t worker, const Task& task)
+{
+	std::size_t index;
+	while (take(worker, index)) {
+		task(index);
+	}
+}
+
+bool sfv::WorkerPool::take(std::size_t worker, std::size_t& task)
+{
+	// Own tasks come off the front, largest first
+	{
+		Queue& queue = *m_queues[worker];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+			return true;
+		}
+	}
+	// Stolen tasks come off the back, leaving the owner its large ones
+	for (std::size_t offset = 1; offset != m_queues.size(); ++offset) {
+		Queue& queue = *m_queues[(worker + offset) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+			return true;
+		}
+	}
+	// Tasks are all dealt out before a round starts, so empty queues stay empty
+	return false;
+}
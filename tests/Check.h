@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef SFV_CHECK_H
+#define SFV_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+// A failed check prints itself and where it is, and the test goes on to exit with a failure
+#define SFV_CHECK(condition) sfv::test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace sfv {
+	namespace test {
+
+		inline std::size_t& getFailureCount()
+		{
+			static std::size_t failures = 0;
+			return failures;
+		}
+
+		inline bool check(bool passed, const char* condition, const char* file, int line)
+		{
+			if (!passed) {
+				std::cerr << file << ":" << line << ": check failed: " << condition << std::endl;
+				++getFailureCount();
+			}
+			return passed;
+		}
+
+		// Exit code of the test
+		inline int getResult()
+		{
+			if (getFailureCount() != 0) {
+				std::cerr << getFailureCount() << " checks failed" << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		}
+	}
+}
+#endif
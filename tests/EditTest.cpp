@@ -0,0 +1,435 @@
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <functional>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "GeometrySink.h"
+#include "GlyphCache.h"
+#include "TestFontMetrics.h"
+#include "VividText.h"
+
+// Makes the same calls on two texts, one of them inside an edit, and checks they end up with the same runs and quads.
+// The fonts are bound to made up metrics, so no window or texture is involved.
+namespace
+{
+	typedef std::function<void(sfv::VividText&)> Call;
+	typedef sfv::RecordingGeometrySink::Upload Upload;
+
+	const sfv::GeometrySink::Layer FILL = sfv::GeometrySink::Fill;
+	const sfv::GeometrySink::Layer OUTLINE = sfv::GeometrySink::Outline;
+
+	// Every quad is two triangles
+	const std::size_t QUAD = 6;
+
+	class NullTarget : public sf::RenderTarget {
+	public:
+		sf::Vector2u getSize() const override
+		{
+			return sf::Vector2u(800, 600);
+		}
+	};
+
+	// Records the uploads without drawing them
+	class UploadLog : public sfv::RecordingGeometrySink {
+	public:
+		void draw(Layer, sf::RenderTarget&, std::size_t, std::size_t, const sf::RenderStates&) override
+		{
+		}
+	};
+
+	// Draw the text and hand back what was uploaded since the last call
+	std::vector<Upload> drawUploads(const sfv::VividText& text, UploadLog& sink)
+	{
+		NullTarget target;
+		target.draw(text);
+		const std::vector<Upload> uploads = sink.getUploads();
+		sink.clearUploads();
+		return uploads;
+	}
+
+	bool sameQuads(const sfv::VividText& left, const sfv::VividText& right, sfv::GeometrySink::Layer layer)
+	{
+		std::vector<sf::Vertex> leftVertices;
+		std::vector<sf::Vertex> rightVertices;
+		left.exportQuads(layer, leftVertices);
+		right.exportQuads(layer, rightVertices);
+		if (leftVertices.size() != rightVertices.size()) {
+			return false;
+		}
+		for (std::size_t index = 0; index != leftVertices.size(); ++index) {
+			const sf::Vertex& vertex = leftVertices[index];
+			const sf::Vertex& other = rightVertices[index];
+			if (vertex.position != other.position || vertex.color != other.color || vertex.texCoords != other.texCoords) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Same characters cut into the same runs, with the same quads
+	bool sameText(const sfv::VividText& left, const sfv::VividText& right)
+	{
+		if (left.getString() != right.getString()) {
+			return false;
+		}
+		for (std::size_t index = 0; index != left.getString().getSize(); ++index) {
+			const sfv::Chunk chunk = left.getChunk(left.getChunkIndex(index));
+			const sfv::Chunk other = right.getChunk(right.getChunkIndex(index));
+			if (left.getChunkIndex(index) != right.getChunkIndex(index) || chunk != other || chunk.length != other.length) {
+				return false;
+			}
+		}
+		return left.getLocalBounds() == right.getLocalBounds() && sameQuads(left, right, FILL) && sameQuads(left, right, OUTLINE);
+	}
+
+	// Make the calls on a text laid out beforehand, inside an edit or one by one
+	void makeCalls(sfv::VividText& text, const std::vector<Call>& calls, bool edit)
+	{
+		text.getLocalBounds();
+		if (edit) {
+			text.beginEdit();
+		}
+		for (const Call& call : calls) {
+			call(text);
+		}
+		if (edit) {
+			SFV_CHECK(text.isEditing());
+			text.commitEdit();
+		}
+		SFV_CHECK(!text.isEditing());
+	}
+
+	bool editMatches(const sf::Font& font, const sf::String& string, const std::vector<Call>& calls)
+	{
+		sfv::VividText edited(string, font);
+		sfv::VividText direct(string, font);
+		makeCalls(edited, calls, true);
+		makeCalls(direct, calls, false);
+		return sameText(edited, direct);
+	}
+
+	// The calls in an edit of their own, opened inside the current one. Outside an edit they are made one by one.
+	Call nested(const std::vector<Call>& calls)
+	{
+		return [calls](sfv::VividText& text) {
+			const bool editing = text.isEditing();
+			if (editing) {
+				text.beginEdit();
+			}
+			for (const Call& call : calls) {
+				call(text);
+			}
+			if (editing) {
+				text.commitEdit();
+			}
+		};
+	}
+
+	Call fill(sf::Color color, std::size_t start, std::size_t length)
+	{
+		return [=](sfv::VividText& text) {
+			text.setFillColor(color, start, length);
+		};
+	}
+
+	Call outline(sf::Color color, std::size_t start, std::size_t length)
+	{
+		return [=](sfv::VividText& text) {
+			text.setOutlineColor(color, start, length);
+		};
+	}
+
+	Call style(sf::Uint32 style, std::size_t start, std::size_t length)
+	{
+		return [=](sfv::VividText& text) {
+			text.setStyle(style, start, length);
+		};
+	}
+
+	Call size(sf::Uint32 characterSize, std::size_t start, std::size_t length)
+	{
+		return [=](sfv::VividText& text) {
+			text.setCharacterSize(characterSize, start, length);
+		};
+	}
+
+	Call thickness(float outlineThickness, std::size_t start, std::size_t length)
+	{
+		return [=](sfv::VividText& text) {
+			text.setOutlineThickness(outlineThickness, start, length);
+		};
+	}
+
+	Call font(const sf::Font& font, std::size_t start, std::size_t length)
+	{
+		return [&font, start, length](sfv::VividText& text) {
+			text.setFont(font, start, length);
+		};
+	}
+
+	Call insert(const sf::String& string, std::size_t index)
+	{
+		return [=](sfv::VividText& text) {
+			text.insert(string, index);
+		};
+	}
+
+	Call erase(std::size_t start, std::size_t length)
+	{
+		return [=](sfv::VividText& text) {
+			text.erase(start, length);
+		};
+	}
+
+	Call glyphFills(const std::vector<sf::Color>& colors, std::size_t start)
+	{
+		return [=](sfv::VividText& text) {
+			text.setGlyphFillColors(colors.data(), start, colors.size());
+		};
+	}
+
+	Call glyphOutlines(const std::vector<sf::Color>& colors, std::size_t start)
+	{
+		return [=](sfv::VividText& text) {
+			text.setGlyphOutlineColors(colors.data(), start, colors.size());
+		};
+	}
+
+	void testSetters(const sf::Font& first, const sf::Font& second)
+	{
+		// Later changes win where they overlap, whatever they change
+		SFV_CHECK(editMatches(first, "Hello World", { fill(sf::Color::Red, 0, 8), fill(sf::Color::Blue, 3, 2), outline(sf::Color::Green, 2, 6) }));
+		SFV_CHECK(editMatches(first, "Hello World", { style(sf::Text::Bold, 2, 5), size(30, 4, 7), thickness(2.f, 0, 3), font(second, 6, 5) }));
+		SFV_CHECK(editMatches(first, "Hello World", { fill(sf::Color::Red, 0, 11), style(sf::Text::Underlined, 3, 4), fill(sf::Color::White, 0, 11) }));
+		// Ranges past the end are cut, and those starting past it do nothing
+		SFV_CHECK(editMatches(first, "Hello", { fill(sf::Color::Red, 3, 100), style(sf::Text::Italic, 9, 2) }));
+
+		// Until the commit the runs keep their attributes
+		sfv::VividText text("Hello World", first);
+		text.beginEdit();
+		text.setFillColor(sf::Color::Red, 0, 5);
+		SFV_CHECK(text.getChunk(0).fillColor == sf::Color::White);
+		text.commitEdit();
+		SFV_CHECK(text.getChunk(0).fillColor == sf::Color::Red && text.getChunk(0).length == 5);
+	}
+
+	void testFragments(const sf::Font& font)
+	{
+		// Text inserted inside a queued range cuts it in two and keeps the attributes it was inserted with
+		SFV_CHECK(editMatches(font, "Hello World", { fill(sf::Color::Red, 2, 6), insert("xyz", 4) }));
+		SFV_CHECK(editMatches(font, "Hello World", { style(sf::Text::Bold, 0, 11), insert("xyz", 0), insert("uv", 14), insert("w", 5) }));
+		// Erases shrink and move the ranges queued before them, and may empty them
+		SFV_CHECK(editMatches(font, "Hello World", { fill(sf::Color::Red, 2, 6), erase(1, 3), erase(5, 4) }));
+		SFV_CHECK(editMatches(font, "Hello World", { size(30, 3, 2), erase(2, 5), fill(sf::Color::Blue, 0, 3) }));
+		// Changes made after an insert or erase cover the text as it is by then
+		SFV_CHECK(editMatches(font, "Hello\nWorld", { insert("ab\n", 3), style(sf::Text::Underlined, 1, 6), erase(0, 2), fill(sf::Color::Green, 2, 4), insert("c", 3) }));
+
+		sfv::VividText text("Hello World", font);
+		text.beginEdit();
+		text.setFillColor(sf::Color::Red, 2, 6);
+		text.insert("xyz", 4);
+		text.commitEdit();
+		SFV_CHECK(text.getChunk(text.getChunkIndex(3)).fillColor == sf::Color::Red);
+		SFV_CHECK(text.getChunk(text.getChunkIndex(4)).fillColor == sf::Color::White);
+		SFV_CHECK(text.getChunk(text.getChunkIndex(7)).fillColor == sf::Color::Red);
+	}
+
+	void testGlyphColors(const sf::Font& font)
+	{
+		const std::vector<sf::Color> rainbow = { sf::Color::Red, sf::Color::Yellow, sf::Color::Green, sf::Color::Cyan, sf::Color::Blue };
+		const std::vector<sf::Color> pair = { sf::Color::Magenta, sf::Color::Magenta };
+
+		// A channel set up inside an edit starts with the colors queued before it
+		SFV_CHECK(editMatches(font, "Hello World, hello", { fill(sf::Color::Red, 0, 10), glyphFills(pair, 12) }));
+		SFV_CHECK(editMatches(font, "Hello World, hello", { outline(sf::Color::Red, 0, 10), thickness(1.f, 0, 18), glyphOutlines(pair, 12) }));
+		// Colors queued before per character ones stay under them, those queued after cover them
+		SFV_CHECK(editMatches(font, "Hello World", { glyphFills(rainbow, 0), fill(sf::Color::Blue, 2, 6), glyphFills(pair, 3), fill(sf::Color::Black, 4, 1) }));
+		SFV_CHECK(editMatches(font, "Hello World", { glyphFills(rainbow, 3), fill(sf::Color::Blue, 0, 4), insert("ab", 1), glyphFills(pair, 0), erase(5, 2) }));
+		SFV_CHECK(editMatches(font, "Hello World", { thickness(1.f, 0, 11), glyphOutlines(rainbow, 2), outline(sf::Color::Red, 0, 5), glyphFills(pair, 6), outline(sf::Color::Blue, 5, 3) }));
+
+		// Either way the first characters are red and the per character ones magenta
+		sfv::VividText text("0123456789abcdefghij", font);
+		text.beginEdit();
+		text.setFillColor(sf::Color::Red, 0, 10);
+		text.setGlyphFillColors(pair.data(), 12, pair.size());
+		text.commitEdit();
+		std::vector<sf::Vertex> vertices;
+		text.exportQuads(FILL, vertices);
+		if (SFV_CHECK(vertices.size() == 20 * 4)) {
+			SFV_CHECK(vertices[0].color == sf::Color::Red && vertices[9 * 4].color == sf::Color::Red);
+			SFV_CHECK(vertices[10 * 4].color == sf::Color::White && vertices[12 * 4].color == sf::Color::Magenta);
+		}
+	}
+
+	void testNesting(const sf::Font& font)
+	{
+		SFV_CHECK(editMatches(font, "Hello World", { fill(sf::Color::Red, 0, 4), nested({ insert("ab", 2), fill(sf::Color::Blue, 1, 3) }), erase(0, 1) }));
+		SFV_CHECK(editMatches(font, "Hello World", { nested({ style(sf::Text::Bold, 0, 6), nested({ erase(3, 2), size(24, 2, 4) }) }), insert("x", 1) }));
+
+		// Only the outermost commit applies the changes
+		sfv::VividText text("Hello World", font);
+		text.beginEdit();
+		text.beginEdit();
+		text.setFillColor(sf::Color::Red, 0, 5);
+		text.commitEdit();
+		SFV_CHECK(text.isEditing());
+		SFV_CHECK(text.getChunk(0).fillColor == sf::Color::White);
+		text.commitEdit();
+		SFV_CHECK(!text.isEditing());
+		SFV_CHECK(text.getChunk(0).fillColor == sf::Color::Red);
+
+		// A commit without an edit does nothing
+		text.commitEdit();
+		SFV_CHECK(!text.isEditing());
+	}
+
+	// An edit that only changes colors patches the quads like the setters do, anything else lays its range out again
+	void testRecolor(const sf::Font& font)
+	{
+		sfv::VividText text("Hello\nWorld", font);
+		text.setCharacterSize(20);
+		UploadLog sink;
+		text.setGeometrySink(&sink);
+		drawUploads(text, sink);
+
+		text.beginEdit();
+		text.setFillColor(sf::Color::Red, 7, 1);
+		text.setFillColor(sf::Color::Blue, 8, 1);
+		text.commitEdit();
+		const std::vector<Upload> recolored = drawUploads(text, sink);
+		if (SFV_CHECK(recolored.size() == 1)) {
+			SFV_CHECK(recolored[0].layer == FILL && recolored[0].first == 6 * QUAD && recolored[0].count == 2 * QUAD);
+		}
+
+		// Outside an edit the same colors upload the same quads
+		text.setFillColor(sf::Color::White);
+		drawUploads(text, sink);
+		text.setFillColor(sf::Color::Red, 7, 1);
+		text.setFillColor(sf::Color::Blue, 8, 1);
+		const std::vector<Upload> direct = drawUploads(text, sink);
+		SFV_CHECK(direct.size() == 1 && direct[0].first == recolored[0].first && direct[0].count == recolored[0].count);
+
+		// An insert moves every quad after it, so the edited line is sent again up to the end
+		text.beginEdit();
+		text.setFillColor(sf::Color::Green, 7, 1);
+		text.insert("X", 9);
+		text.commitEdit();
+		const std::vector<Upload> relaid = drawUploads(text, sink);
+		if (SFV_CHECK(relaid.size() == 1)) {
+			SFV_CHECK(relaid[0].layer == FILL && relaid[0].first == 5 * QUAD && relaid[0].count == 6 * QUAD);
+		}
+
+		// A change of anything but colors lays out the line again, here without moving the next one
+		text.beginEdit();
+		text.setFillColor(sf::Color::Green, 1, 1);
+		text.setStyle(sf::Text::Bold, 2, 1);
+		text.commitEdit();
+		const std::vector<Upload> restyled = drawUploads(text, sink);
+		if (SFV_CHECK(restyled.size() == 1)) {
+			SFV_CHECK(restyled[0].layer == FILL && restyled[0].first == 0 && restyled[0].count == 5 * QUAD);
+		}
+	}
+
+	// Random mixes of every call, drawn from a fixed seed
+	void testMixes(const sf::Font& first, const sf::Font& second)
+	{
+		const sf::Color palette[] = { sf::Color::Red, sf::Color::Green, sf::Color::Blue, sf::Color::Black };
+		std::mt19937 random(7);
+		const auto pick = [&random](std::size_t count) {
+			return static_cast<std::size_t>(random() % count);
+		};
+		std::size_t mismatches = 0;
+		for (int mix = 0; mix != 200; ++mix) {
+			sf::String string;
+			for (std::size_t length = pick(40); length != 0; --length) {
+				string += static_cast<sf::Uint32>("AVb c\n"[pick(6)]);
+			}
+			// Calls are made on the text as it is, so the ranges are drawn against a running length
+			std::size_t length = string.getSize();
+			std::vector<Call> calls;
+			// Runs of calls go in an inner edit now and then
+			std::vector<Call> inner;
+			bool nesting = false;
+			for (std::size_t count = 1 + pick(12); count != 0; --count) {
+				const std::size_t start = pick(length + 2);
+				const std::size_t span = pick(10);
+				const sf::Color color = palette[pick(4)];
+				nesting = nesting || pick(5) == 0;
+				std::vector<Call>& target = nesting ? inner : calls;
+				switch (pick(11)) {
+				case 0:
+					target.push_back(fill(color, start, span));
+					break;
+				case 1:
+					target.push_back(outline(color, start, span));
+					break;
+				case 2:
+					target.push_back(style(static_cast<sf::Uint32>(pick(16)), start, span));
+					break;
+				case 3:
+					target.push_back(size(static_cast<sf::Uint32>(16 + 4 * pick(3)), start, span));
+					break;
+				case 4:
+					target.push_back(thickness(static_cast<float>(pick(3)), start, span));
+					break;
+				case 5:
+					target.push_back(font(pick(2) == 0 ? first : second, start, span));
+					break;
+				case 6:
+				case 7: {
+					sf::String text;
+					for (std::size_t letter = 1 + pick(3); letter != 0; --letter) {
+						text += static_cast<sf::Uint32>("xy \n"[pick(4)]);
+					}
+					target.push_back(insert(text, std::min(start, length)));
+					length += text.getSize();
+					break;
+				}
+				case 8:
+					if (start < length) {
+						target.push_back(erase(start, span));
+						length -= std::min(span, length - start);
+					}
+					break;
+				case 9:
+					target.push_back(glyphFills(std::vector<sf::Color>(span, color), start));
+					break;
+				default:
+					target.push_back(glyphOutlines(std::vector<sf::Color>(span, color), start));
+					break;
+				}
+				if (nesting && pick(3) == 0) {
+					calls.push_back(nested(inner));
+					inner.clear();
+					nesting = false;
+				}
+			}
+			if (!inner.empty()) {
+				calls.push_back(nested(inner));
+			}
+			mismatches += editMatches(first, string, calls) ? 0 : 1;
+		}
+		SFV_CHECK(mismatches == 0);
+	}
+}
+
+int main()
+{
+	const sf::Font first;
+	const sf::Font second;
+	sfv::test::TestFontMetrics metrics;
+	sfv::GlyphCache::bind(first, metrics);
+	sfv::GlyphCache::bind(second, metrics);
+
+	testSetters(first, second);
+	testFragments(first);
+	testGlyphColors(first);
+	testNesting(first);
+	testRecolor(first);
+	testMixes(first, second);
+
+	sfv::GlyphCache::release(second);
+	sfv::GlyphCache::release(first);
+	return sfv::test::getResult();
+}
@@ -0,0 +1,145 @@
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <vector>
+#include "Check.h"
+#include "GeometrySink.h"
+#include "GlyphCache.h"
+#include "TestFontMetrics.h"
+#include "VividText.h"
+
+// Edits a two line text and checks which vertex ranges reach a recording sink on the next draw.
+// The font is bound to made up metrics and the target draws nothing, so no window or texture is involved.
+namespace
+{
+	typedef sfv::RecordingGeometrySink::Upload Upload;
+
+	const sfv::GeometrySink::Layer FILL = sfv::GeometrySink::Fill;
+	const sfv::GeometrySink::Layer OUTLINE = sfv::GeometrySink::Outline;
+
+	// Every quad is two triangles
+	const std::size_t QUAD = 6;
+
+	class NullTarget : public sf::RenderTarget {
+	public:
+		sf::Vector2u getSize() const override
+		{
+			return sf::Vector2u(800, 600);
+		}
+	};
+
+	// Records the uploads without drawing them
+	class UploadLog : public sfv::RecordingGeometrySink {
+	public:
+		void draw(Layer, sf::RenderTarget&, std::size_t, std::size_t, const sf::RenderStates&) override
+		{
+		}
+	};
+
+	bool sameUploads(const std::vector<Upload>& uploads, const std::vector<Upload>& expected)
+	{
+		if (uploads.size() != expected.size()) {
+			return false;
+		}
+		for (std::size_t index = 0; index != uploads.size(); ++index) {
+			const Upload& upload = uploads[index];
+			const Upload& other = expected[index];
+			if (upload.layer != other.layer || upload.first != other.first || upload.count != other.count || upload.size != other.size) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool sameVertices(const std::vector<sf::Vertex>& left, const std::vector<sf::Vertex>& right)
+	{
+		if (left.size() != right.size()) {
+			return false;
+		}
+		for (std::size_t index = 0; index != left.size(); ++index) {
+			if (left[index].position != right[index].position || left[index].color != right[index].color || left[index].texCoords != right[index].texCoords) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Draw the text and hand back what was uploaded since the last call
+	std::vector<Upload> drawUploads(const sfv::VividText& text, UploadLog& sink)
+	{
+		NullTarget target;
+		target.draw(text);
+		const std::vector<Upload> uploads = sink.getUploads();
+		sink.clearUploads();
+		return uploads;
+	}
+
+	// The vertices patched together from partial uploads are those a fresh sink is sent in one go
+	bool matchesFullUpload(sfv::VividText& text, UploadLog& sink)
+	{
+		UploadLog full;
+		text.setGeometrySink(&full);
+		drawUploads(text, full);
+		const bool same = sameVertices(sink.getVertices(FILL), full.getVertices(FILL)) && sameVertices(sink.getVertices(OUTLINE), full.getVertices(OUTLINE));
+		text.setGeometrySink(&sink);
+		drawUploads(text, sink);
+		return same;
+	}
+
+	void testUploads(const sf::Font& font)
+	{
+		// Ten glyphs, the first five on the first line and the newline without a quad
+		sfv::VividText text("Hello\nWorld", font);
+		text.setCharacterSize(20);
+		UploadLog sink;
+		text.setGeometrySink(&sink);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { FILL, 0, 10 * QUAD, 10 * QUAD } }));
+
+		// Static text uploads nothing
+		SFV_CHECK(drawUploads(text, sink).empty());
+		SFV_CHECK(drawUploads(text, sink).empty());
+
+		// An edit rewrites its line, the lines before it keep their vertices
+		text.insert("X", 8);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { FILL, 5 * QUAD, 6 * QUAD, 11 * QUAD } }));
+		SFV_CHECK(matchesFullUpload(text, sink));
+
+		text.erase(8);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { FILL, 5 * QUAD, 5 * QUAD, 10 * QUAD } }));
+		SFV_CHECK(matchesFullUpload(text, sink));
+
+		// The quads of the lines after an edit move in the array, so they are sent again too
+		text.insert("X", 2);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { FILL, 0, 11 * QUAD, 11 * QUAD } }));
+		text.erase(2);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { FILL, 0, 10 * QUAD, 10 * QUAD } }));
+		SFV_CHECK(matchesFullUpload(text, sink));
+
+		// A new color only patches the quad of its character, the o of World
+		text.setFillColor(sf::Color::Red, 7, 1);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { FILL, 6 * QUAD, QUAD, 10 * QUAD } }));
+		const std::vector<sf::Vertex>& vertices = sink.getVertices(FILL);
+		for (std::size_t index = 0; index != vertices.size(); ++index) {
+			const bool recolored = index >= 6 * QUAD && index < 7 * QUAD;
+			SFV_CHECK(vertices[index].color == (recolored ? sf::Color::Red : sf::Color::White));
+		}
+		SFV_CHECK(matchesFullUpload(text, sink));
+
+		// Outlines go to their own layer, recoloring them leaves the fill alone
+		text.setOutlineThickness(1.f);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { OUTLINE, 0, 10 * QUAD, 10 * QUAD }, { FILL, 0, 10 * QUAD, 10 * QUAD } }));
+		text.setOutlineColor(sf::Color::Blue, 1, 1);
+		SFV_CHECK(sameUploads(drawUploads(text, sink), { { OUTLINE, QUAD, QUAD, 10 * QUAD } }));
+		SFV_CHECK(matchesFullUpload(text, sink));
+	}
+}
+
+int main()
+{
+	const sf::Font font;
+	sfv::test::TestFontMetrics metrics;
+	sfv::GlyphCache::bind(font, metrics);
+
+	testUploads(font);
+
+	sfv::GlyphCache::release(font);
+	return sfv::test::getResult();
+}
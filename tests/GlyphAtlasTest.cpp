@@ -0,0 +1,146 @@
+#include <SFML/Graphics/Image.hpp>
+#include <vector>
+#include "Check.h"
+#include "GlyphAtlas.h"
+
+// Packs rects of sf::Image sources into small atlas pages, without any texture or graphics context
+namespace
+{
+	const std::size_t NO_PAGE = static_cast<std::size_t>(-1);
+
+	// Every pixel tells where it comes from
+	sf::Image makeSource(unsigned int size, sf::Uint8 tag)
+	{
+		sf::Image image;
+		image.create(size, size);
+		for (unsigned int x = 0; x != size; ++x) {
+			for (unsigned int y = 0; y != size; ++y) {
+				image.setPixel(x, y, sf::Color(static_cast<sf::Uint8>(x), static_cast<sf::Uint8>(y), tag, 255));
+			}
+		}
+		return image;
+	}
+
+	// The rect grown by the pixel of padding the packer leaves on its right and bottom
+	sf::IntRect padded(const sf::IntRect& rect)
+	{
+		return sf::IntRect(rect.left, rect.top, rect.width + 1, rect.height + 1);
+	}
+
+	bool copied(const sf::Image& page, const sf::IntRect& placed, const sf::Image& source, const sf::IntRect& rect)
+	{
+		for (int x = 0; x != rect.width; ++x) {
+			for (int y = 0; y != rect.height; ++y) {
+				const sf::Color expected = source.getPixel(static_cast<unsigned int>(rect.left + x), static_cast<unsigned int>(rect.top + y));
+				if (page.getPixel(static_cast<unsigned int>(placed.left + x), static_cast<unsigned int>(placed.top + y)) != expected) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Placements stay on the page, clear of the white block, of each other and of their padding
+	void checkLayout(const std::vector<sf::IntRect>& placed, unsigned int pageSize)
+	{
+		const int size = static_cast<int>(pageSize);
+		for (std::size_t index = 0; index != placed.size(); ++index) {
+			const sf::IntRect& rect = placed[index];
+			SFV_CHECK(rect.left >= 0 && rect.top >= 0 && rect.left + rect.width <= size && rect.top + rect.height <= size);
+			SFV_CHECK(!padded(sf::IntRect(0, 0, 2, 2)).intersects(rect));
+			for (std::size_t other = 0; other != placed.size(); ++other) {
+				if (other != index) {
+					SFV_CHECK(!padded(rect).intersects(placed[other]));
+				}
+			}
+		}
+	}
+
+	void testPlacement()
+	{
+		sfv::GlyphAtlas atlas(64);
+		const sf::Image source = makeSource(64, 1);
+		const std::vector<sf::IntRect> rects = {
+			{ 0, 0, 10, 12 }, { 10, 0, 3, 12 }, { 20, 5, 9, 11 }, { 0, 20, 12, 12 }, { 30, 30, 5, 5 },
+			{ 40, 0, 7, 10 }, { 12, 40, 10, 12 }, { 50, 50, 14, 14 }, { 0, 0, 0, 0 }
+		};
+		std::vector<sf::IntRect> placed(rects.size());
+		SFV_CHECK(atlas.insert(&source, source, rects.data(), rects.size(), placed.data()) == 0);
+		SFV_CHECK(atlas.getPageCount() == 1);
+
+		// Empty rects are handed back as they are, the others keep their size and pixels
+		SFV_CHECK(placed.back() == rects.back());
+		placed.pop_back();
+		const sf::Image& page = atlas.getImage(0);
+		SFV_CHECK(page.getSize() == sf::Vector2u(64, 64));
+		for (std::size_t index = 0; index != placed.size(); ++index) {
+			SFV_CHECK(placed[index].width == rects[index].width && placed[index].height == rects[index].height);
+			SFV_CHECK(copied(page, placed[index], source, rects[index]));
+		}
+		checkLayout(placed, 64);
+
+		// Lines are textured from the 2x2 white block in the corner
+		for (unsigned int x = 0; x != 2; ++x) {
+			for (unsigned int y = 0; y != 2; ++y) {
+				SFV_CHECK(page.getPixel(x, y) == sf::Color::White);
+			}
+		}
+
+		// Rects already on the page are found again instead of being copied twice
+		std::vector<sf::IntRect> again(rects.size());
+		SFV_CHECK(atlas.insert(&source, source, rects.data(), rects.size(), again.data()) == 0);
+		again.pop_back();
+		SFV_CHECK(again == placed);
+		SFV_CHECK(atlas.getPageCount() == 1);
+	}
+
+	void testPageGrowth()
+	{
+		// 20x20 glyphs take rows 23 pixels high below the white block, so a page of 64 holds two rows of three
+		sfv::GlyphAtlas atlas(64);
+		const sf::Image first = makeSource(64, 1);
+		const sf::Image second = makeSource(64, 2);
+		const sf::IntRect pair[2] = { { 0, 0, 20, 20 }, { 20, 20, 20, 20 } };
+		std::vector<sf::IntRect> placed;
+		for (int batch = 0; batch != 3; ++batch) {
+			sf::IntRect rects[2] = { pair[0], pair[1] };
+			rects[0].top = rects[1].top = batch * 5;
+			sf::IntRect out[2];
+			SFV_CHECK(atlas.insert(&first, first, rects, 2, out) == 0);
+			placed.insert(placed.end(), out, out + 2);
+		}
+		SFV_CHECK(atlas.getPageCount() == 1);
+		checkLayout(placed, 64);
+
+		// A set that doesn't fit moves to a new page as a whole
+		sf::IntRect out[2];
+		SFV_CHECK(atlas.insert(&second, second, pair, 2, out) == 1);
+		SFV_CHECK(atlas.getPageCount() == 2);
+		checkLayout(std::vector<sf::IntRect>(out, out + 2), 64);
+		SFV_CHECK(copied(atlas.getImage(1), out[0], second, pair[0]));
+		SFV_CHECK(copied(atlas.getImage(1), out[1], second, pair[1]));
+		SFV_CHECK(atlas.getImage(1).getPixel(0, 0) == sf::Color::White);
+
+		// Rects placed on an earlier page are copied to the last one, so a text is drawn from a single page
+		sf::IntRect moved[2];
+		SFV_CHECK(atlas.insert(&first, first, pair, 2, moved) == 1);
+		SFV_CHECK(copied(atlas.getImage(1), moved[0], first, pair[0]));
+		checkLayout({ out[0], out[1], moved[0], moved[1] }, 64);
+
+		// A rect larger than an empty page fits nowhere
+		const sf::IntRect huge(0, 0, 40, 70);
+		const sf::Image tall = makeSource(80, 3);
+		sf::IntRect nowhere;
+		SFV_CHECK(atlas.insert(&tall, tall, &huge, 1, &nowhere) == NO_PAGE);
+
+		atlas.clear();
+		SFV_CHECK(atlas.getPageCount() == 0);
+	}
+}
+
+int main()
+{
+	testPlacement();
+	testPageGrowth();
+	return sfv::test::getResult();
+}
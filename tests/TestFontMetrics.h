@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef SFV_TEST_FONT_METRICS_H
+#define SFV_TEST_FONT_METRICS_H
+
+#include <atomic>
+#include <thread>
+#include "FontMetrics.h"
+
+namespace sfv {
+	namespace test {
+
+		// Made up font with round numbers, bound to an unloaded sf::Font so tests need no graphics context.
+		// Every glyph advances half the character size and rises 0.7 of it from the baseline with a pixel
+		// of bearing on each side, a space advances a quarter, "AV" kerns by minus a tenth and lines are
+		// 1.5 times the character size apart. Metrics read on another thread than the one that made it are counted.
+		class TestFontMetrics : public FontMetrics {
+		private:
+			std::thread::id m_thread;
+			std::atomic<std::size_t> m_reads;
+			std::atomic<std::size_t> m_foreignReads;
+
+			void read()
+			{
+				++m_reads;
+				if (std::this_thread::get_id() != m_thread) {
+					++m_foreignReads;
+				}
+			}
+		public:
+			TestFontMetrics()
+				: m_thread(std::this_thread::get_id()),
+				m_reads(0),
+				m_foreignReads(0)
+			{
+			}
+
+			sf::Glyph getGlyph(sf::Uint32 codePoint, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f) override
+			{
+				read();
+				const float size = static_cast<float>(characterSize);
+				sf::Glyph glyph;
+				glyph.advance = codePoint == L' ' ? size / 4.f : size / 2.f + (bold ? 1.f : 0.f);
+				glyph.bounds = sf::FloatRect(1.f - outlineThickness, -size * 0.7f - outlineThickness, glyph.advance - 2.f + outlineThickness * 2.f, size * 0.7f + outlineThickness * 2.f);
+				glyph.textureRect = sf::IntRect(static_cast<int>(codePoint % 64) * 32, bold ? 32 : 0, static_cast<int>(glyph.bounds.width), static_cast<int>(glyph.bounds.height));
+				return glyph;
+			}
+
+			float getKerning(sf::Uint32 first, sf::Uint32 second, sf::Uint32 characterSize) override
+			{
+				read();
+				return first == L'A' && second == L'V' ? -static_cast<float>(characterSize) / 10.f : 0.f;
+			}
+
+			float getLineSpacing(sf::Uint32 characterSize) override
+			{
+				read();
+				return static_cast<float>(characterSize) * 1.5f;
+			}
+
+			float getUnderlinePosition(sf::Uint32 characterSize) override
+			{
+				read();
+				return static_cast<float>(characterSize) / 10.f;
+			}
+
+			float getUnderlineThickness(sf::Uint32 characterSize) override
+			{
+				read();
+				return static_cast<float>(characterSize) / 20.f;
+			}
+
+			std::size_t getReadCount() const
+			{
+				return m_reads;
+			}
+
+			std::size_t getForeignReadCount() const
+			{
+				return m_foreignReads;
+			}
+		};
+	}
+}
+#endif
@@ -0,0 +1,164 @@
+#include <SFML/Graphics/Font.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "GlyphCache.h"
+#include "TestFontMetrics.h"
+#include "TextLayout.h"
+#include "WorkerPool.h"
+
+// Lays text out with made up metrics bound to a font that is never loaded, so no window or texture is involved.
+// At size 20 a glyph advances 10 and spans [1, 9] x [-14, 0] around the pen, a space advances 5,
+// "AV" kerns by -2 and lines are 30 apart.
+namespace
+{
+	const sf::Uint32 SIZE = 20;
+
+	sfv::TextLayout::Result layOut(const sf::Font& font, const sf::String& text, float maxWidth = 0.f, sfv::WorkerPool* pool = nullptr, std::atomic<bool>* missed = nullptr)
+	{
+		const sfv::TextStorage string(text);
+		sfv::Chunk chunk(text.getSize(), &font);
+		chunk.characterSize = SIZE;
+		sfv::ChunkTree chunks;
+		chunks.assign({ chunk });
+		sfv::TextLayout::Result result;
+		sfv::TextLayout(string, chunks, maxWidth, sfv::TextLayout::GlyphAttributes(), missed).layout(result, pool);
+		return result;
+	}
+
+	// Pen positions of the characters of a line
+	std::vector<float> penPositions(const sfv::TextLayout::Result& result, std::size_t line)
+	{
+		const sfv::TextLayout::Line& data = result.lines[line];
+		const auto first = result.offsets.begin() + static_cast<std::ptrdiff_t>(data.start);
+		return std::vector<float>(first, first + static_cast<std::ptrdiff_t>(data.length));
+	}
+
+	void testParagraphs(const sf::Font& font)
+	{
+		const sfv::TextLayout::Result result = layOut(font, "AVA B\nCD");
+		if (!SFV_CHECK(result.lines.size() == 2)) {
+			return;
+		}
+		const sfv::TextLayout::Line& first = result.lines[0];
+		const sfv::TextLayout::Line& second = result.lines[1];
+		SFV_CHECK(first.start == 0 && first.length == 6);
+		SFV_CHECK(second.start == 6 && second.length == 2);
+
+		// V is pulled back by the kerning after its pen position is taken, the newline sits past B
+		SFV_CHECK(penPositions(result, 0) == std::vector<float>({ 0.f, 10.f, 18.f, 28.f, 33.f, 43.f }));
+		SFV_CHECK(penPositions(result, 1) == std::vector<float>({ 0.f, 10.f }));
+		SFV_CHECK(first.advance == 43.f && second.advance == 20.f);
+
+		// The first baseline sits one character size down, the next one a rounded line spacing below it
+		SFV_CHECK(first.height == 30.f && second.height == 30.f);
+		SFV_CHECK(first.y == 20.f);
+		SFV_CHECK(second.y == 20.f + sfv::TextLayout::lineAdvance(30.f, 30.f));
+		SFV_CHECK(sfv::TextLayout::lineAdvance(30.f, 30.f) == 30.f);
+
+		// One quad per visible glyph, placed at its pen position plus its bearing
+		if (SFV_CHECK(result.instances.size() == 6)) {
+			SFV_CHECK(result.instances[0].position == sf::Vector2f(1.f, 6.f));
+			SFV_CHECK(result.instances[1].position == sf::Vector2f(9.f, 6.f));
+			SFV_CHECK(result.instances[3].position == sf::Vector2f(34.f, 6.f));
+			SFV_CHECK(result.instances[5].position == sf::Vector2f(11.f, 36.f));
+			SFV_CHECK(result.shapes[result.instances[0].shape].size == sf::Vector2f(8.f, 14.f));
+		}
+		SFV_CHECK(result.outlineInstances.empty());
+		SFV_CHECK(result.segments.size() == 2);
+
+		// From the left bearing of the first A and the top of the glyphs to the right of B and the second baseline
+		SFV_CHECK(result.bounds == sf::FloatRect(1.f, 6.f, 41.f, 44.f));
+	}
+
+	void testWrapping(const sf::Font& font)
+	{
+		// Words are "AB ", "CD " and "EF", 20 wide each plus a space of 5
+		const sfv::TextLayout::Result fits = layOut(font, "AB CD EF", 45.f);
+		if (SFV_CHECK(fits.lines.size() == 2)) {
+			SFV_CHECK(fits.lines[0].start == 0 && fits.lines[0].length == 6);
+			SFV_CHECK(fits.lines[1].start == 6 && fits.lines[1].length == 2);
+			SFV_CHECK(penPositions(fits, 1) == std::vector<float>({ 0.f, 10.f }));
+			SFV_CHECK(fits.lines[1].y == 50.f);
+			SFV_CHECK(fits.words.size() == 3);
+		}
+
+		const sfv::TextLayout::Result narrow = layOut(font, "AB CD EF", 44.f);
+		if (SFV_CHECK(narrow.lines.size() == 3)) {
+			SFV_CHECK(narrow.lines[1].start == 3 && narrow.lines[1].length == 3);
+			SFV_CHECK(narrow.lines[2].start == 6);
+			SFV_CHECK(narrow.lines[2].y == 80.f);
+			// The spaces ending the first two lines reach 25
+			SFV_CHECK(narrow.bounds == sf::FloatRect(1.f, 6.f, 24.f, 74.f));
+		}
+
+		// A word wider than the maximum width overflows a line of its own, trailing spaces count in the bounds
+		const sfv::TextLayout::Result overflow = layOut(font, "ABCDEFGH IJ", 30.f);
+		if (SFV_CHECK(overflow.lines.size() == 2)) {
+			SFV_CHECK(overflow.lines[0].length == 9);
+			SFV_CHECK(overflow.lines[0].advance == 85.f);
+			SFV_CHECK(overflow.bounds.width == 84.f);
+		}
+
+		// Without a maximum width nothing wraps
+		SFV_CHECK(layOut(font, "AB CD EF").lines.size() == 1);
+	}
+
+	// Paragraphs handed to the workers only find metrics warmed on this thread, and come out as a single pass lays them
+	void testWorkers(const sf::Font& font, const sfv::test::TestFontMetrics& metrics)
+	{
+		sf::String text;
+		for (int paragraph = 0; paragraph != 300; ++paragraph) {
+			text += "The quick brown fox jumps over the lazy dog AVAVA " + std::to_string(paragraph) + "\n";
+		}
+		sfv::GlyphCache::get(font).clear();
+		sfv::WorkerPool pool(4);
+		const sfv::TextLayout::Result parallel = layOut(font, text, 120.f, &pool);
+		const sfv::TextLayout::Result serial = layOut(font, text, 120.f);
+		SFV_CHECK(metrics.getForeignReadCount() == 0);
+		SFV_CHECK(parallel.lines.size() == serial.lines.size() && parallel.lines.size() > 600);
+		SFV_CHECK(parallel.offsets == serial.offsets);
+		SFV_CHECK(parallel.bounds == serial.bounds);
+		if (SFV_CHECK(parallel.instances.size() == serial.instances.size())) {
+			bool same = true;
+			for (std::size_t index = 0; index != serial.instances.size(); ++index) {
+				same = same && parallel.instances[index].position == serial.instances[index].position && parallel.instances[index].shape == serial.instances[index].shape;
+			}
+			SFV_CHECK(same);
+		}
+	}
+
+	// Given a miss flag, layout never reads the font and reports what the caches lacked
+	void testMisses(const sf::Font& font, const sfv::test::TestFontMetrics& metrics)
+	{
+		sfv::GlyphCache::get(font).clear();
+		const std::size_t reads = metrics.getReadCount();
+		std::atomic<bool> missed(false);
+		layOut(font, "AB", 0.f, nullptr, &missed);
+		SFV_CHECK(missed.load());
+		SFV_CHECK(metrics.getReadCount() == reads);
+
+		// Once a layout has read them, the metrics are found
+		layOut(font, "AB");
+		missed = false;
+		const sfv::TextLayout::Result found = layOut(font, "AB", 0.f, nullptr, &missed);
+		SFV_CHECK(!missed.load());
+		SFV_CHECK(found.bounds == layOut(font, "AB").bounds);
+	}
+}
+
+int main()
+{
+	const sf::Font font;
+	sfv::test::TestFontMetrics metrics;
+	sfv::GlyphCache::bind(font, metrics);
+
+	testParagraphs(font);
+	testWrapping(font);
+	testWorkers(font, metrics);
+	testMisses(font, metrics);
+
+	sfv::GlyphCache::release(font);
+	return sfv::test::getResult();
+}